@@ -0,0 +1,126 @@
+// Сравнение flat::HashMap с std::unordered_map на индексах справочника: имена остановок
+// и пары остановок с расстояниями. Выводит скорость поиска и память на элемент
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <malloc.h>
+
+#include "../flat_hash_map.h"
+
+using namespace std;
+
+namespace {
+
+const size_t STOP_COUNT = 100'000;
+const size_t PAIR_COUNT = 300'000;
+const size_t LOOKUP_COUNT = 5'000'000;
+
+struct Stop {
+    string name;
+};
+
+using StopPair = pair<const Stop*, const Stop*>;
+
+// Хэш пары остановок до перехода на flat::HashMap
+struct OldPairHash {
+    size_t operator()(const StopPair& p) const {
+        return p_hash_(p.first) * static_cast<size_t>(pow(59, 4)) + p_hash_(p.second) * 59;
+    }
+private:
+    hash<const void*> p_hash_;
+};
+
+// Текущий хэш пары остановок (TrC::detail::PairHash)
+struct PairHash {
+    size_t operator()(const StopPair& p) const {
+        return flat::HashCombine(p_hash_(p.first), p_hash_(p.second));
+    }
+private:
+    hash<const void*> p_hash_;
+};
+
+// Память, выделенная через malloc, включая большие блоки, отображённые через mmap
+size_t AllocatedBytes() {
+    const auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// Строит таблицу функцией build, затем ищет ключи keys[order[i]]; печатает скорость и память
+template <typename Map, typename Keys, typename Build>
+void Measure(string_view title, const Keys& keys, const vector<uint32_t>& order, Build build) {
+    const size_t before = AllocatedBytes();
+    auto map = make_unique<Map>();
+    build(*map);
+    const size_t memory = AllocatedBytes() - before;
+
+    const auto start = chrono::steady_clock::now();
+    uint64_t checksum = 0;
+    for (uint32_t i : order) {
+        checksum += map->find(keys[i])->second;
+    }
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    cout << setw(40) << left << title << fixed << setprecision(1)
+         << setw(6) << right << order.size() / elapsed.count() / 1e6 << " M/s, "
+         << setw(5) << static_cast<double>(memory) / keys.size() << " B/entry"
+         << " (checksum " << checksum << ")\n";
+}
+
+} // namespace
+
+int main() {
+    mt19937_64 random(42);
+
+    vector<unique_ptr<Stop>> stops;
+    vector<string_view> names;
+    stops.reserve(STOP_COUNT);
+    names.reserve(STOP_COUNT);
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        stops.push_back(make_unique<Stop>(Stop{"Stop "s + to_string(random())}));
+        names.push_back(stops.back()->name);
+    }
+
+    vector<StopPair> pairs;
+    pairs.reserve(PAIR_COUNT);
+    uniform_int_distribution<size_t> stop_index(0, STOP_COUNT - 1);
+    for (size_t i = 0; i < PAIR_COUNT; ++i) {
+        pairs.emplace_back(stops[stop_index(random)].get(), stops[stop_index(random)].get());
+    }
+
+    // Одинаковые пары остановок встречаются редко; повторы не влияют на сравнение
+    const auto fill_names = [&names](auto& map) {
+        for (size_t i = 0; i < names.size(); ++i) {
+            map[names[i]] = static_cast<uint32_t>(i);
+        }
+    };
+    const auto fill_pairs = [&pairs](auto& map) {
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            map[pairs[i]] = static_cast<uint32_t>(i);
+        }
+    };
+
+    vector<uint32_t> name_order(LOOKUP_COUNT);
+    vector<uint32_t> pair_order(LOOKUP_COUNT);
+    for (size_t i = 0; i < LOOKUP_COUNT; ++i) {
+        name_order[i] = static_cast<uint32_t>(random() % names.size());
+        pair_order[i] = static_cast<uint32_t>(random() % pairs.size());
+    }
+
+    Measure<unordered_map<string_view, uint32_t>>("stop names: unordered_map"sv, names, name_order, fill_names);
+    Measure<flat::HashMap<string_view, uint32_t>>("stop names: flat::HashMap"sv, names, name_order, fill_names);
+    Measure<unordered_map<StopPair, uint32_t, OldPairHash>>("stop pairs: unordered_map + old PairHash"sv,
+                                                            pairs, pair_order, fill_pairs);
+    Measure<flat::HashMap<StopPair, uint32_t, PairHash>>("stop pairs: flat::HashMap + PairHash"sv,
+                                                         pairs, pair_order, fill_pairs);
+}
@@ -0,0 +1,172 @@
+#include "city_registry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+CityRegistry::CityRegistry(map<string, string, less<>> bases, size_t memory_budget)
+    : bases_(move(bases)), memory_budget_(memory_budget) {
+}
+
+CityRegistry::~CityRegistry() {
+    // Фоновые загрузки обращаются к реестру, поэтому дожидаемся их
+    for (auto& prefetch : prefetches_) {
+        prefetch.wait();
+    }
+}
+
+bool City::Load(const string& path) {
+    if (!handler.Deserialize(path, router)) {
+        return false;
+    }
+    EstimateMemory();
+    return true;
+}
+
+void City::Build(const City& base, const TrC::CatalogueUpdate& update) {
+    TrC::ApplyUpdate(base.catalogue, update, catalogue);
+    renderer.SetSettings(base.renderer.GetSettings());
+    const router::RoutingSettings settings = base.router.GetRoutingSettings();
+    router.SetRoutingSettings(settings);
+    router.GetGraph() = router::GraphInit(settings, catalogue);
+    router.GetRouter().GetRoutesInternalData() = move(graph::Router<router::RouteWeight>(router.GetGraph()).GetRoutesInternalData());
+    handler.UpdateMap();
+    EstimateMemory();
+}
+
+void City::EstimateMemory() {
+    memory = 0;
+    for (const auto& usage : catalogue.GetMemoryUsage()) {
+        memory += usage.bytes;
+    }
+    for (const auto& usage : router.GetMemoryUsage()) {
+        memory += usage.bytes;
+    }
+    memory += renderer.GetMap().capacity();
+}
+
+shared_ptr<City> CityRegistry::Load(const string& name) const {
+    auto city = make_shared<City>();
+    if (!city->Load(bases_.find(name)->second)) {
+        throw runtime_error("Failed to load base of city "s + name);
+    }
+    return city;
+}
+
+shared_ptr<City> CityRegistry::Get(string_view name) {
+    if (!bases_.count(name)) {
+        throw out_of_range("Unknown city "s + string(name));
+    }
+
+    shared_future<shared_ptr<City>> future;
+    promise<shared_ptr<City>> loading;
+    bool load = false;
+    {
+        lock_guard guard(mutex_);
+        auto it = entries_.find(name);
+        if (it == entries_.end()) {
+            it = entries_.emplace(string(name), Entry{loading.get_future().share()}).first;
+            load = true;
+        }
+        it->second.last_used = ++clock_;
+        future = it->second.city;
+    }
+    if (!load) {
+        return future.get();
+    }
+
+    // Загрузка идёт без блокировки, чтобы другие города загружались и использовались параллельно
+    shared_ptr<City> city;
+    try {
+        city = Load(string(name));
+    }
+    catch (...) {
+        // Запись с ошибкой остаётся: повреждённая база не загружается заново при каждом обращении
+        loading.set_exception(current_exception());
+        throw;
+    }
+    loading.set_value(city);
+
+    lock_guard guard(mutex_);
+    Entry& entry = entries_.find(name)->second;
+    entry.memory = city->memory;
+    entry.loaded = true;
+    memory_ += city->memory;
+    EvictLocked(name);
+    return city;
+}
+
+void CityRegistry::EvictLocked(string_view keep) {
+    while (memory_ > memory_budget_) {
+        auto victim = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            // Город, который сейчас используется, держит ещё хотя бы одну ссылку
+            if (!it->second.loaded || it->first == keep || it->second.city.get().use_count() > 1) {
+                continue;
+            }
+            if (victim == entries_.end() || it->second.last_used < victim->second.last_used) {
+                victim = it;
+            }
+        }
+        if (victim == entries_.end()) {
+            return;
+        }
+        memory_ -= victim->second.memory;
+        entries_.erase(victim);
+    }
+}
+
+void CityRegistry::Preload() {
+    for (const auto& [name, path] : bases_) {
+        if (GetMemoryUsage() >= memory_budget_) {
+            return;
+        }
+        try {
+            Get(name);
+        }
+        catch (const exception& error) {
+            cerr << error.what() << endl;
+        }
+    }
+}
+
+void CityRegistry::Prefetch(string_view name) {
+    if (!bases_.count(name)) {
+        return;
+    }
+    // Prefetch вызывается из нескольких потоков обработки запросов, поэтому список загрузок
+    // изменяется под той же блокировкой, что и записи городов
+    lock_guard guard(mutex_);
+    if (entries_.count(name)) {
+        return;
+    }
+    // Завершившиеся фоновые загрузки больше не нужны
+    prefetches_.erase(remove_if(prefetches_.begin(), prefetches_.end(), [](const future<void>& prefetch) {
+        return prefetch.wait_for(chrono::seconds(0)) == future_status::ready;
+    }), prefetches_.end());
+    prefetches_.push_back(async(launch::async, [this, city = string(name)] {
+        try {
+            Get(city);
+        }
+        catch (const exception&) {
+            // Ошибка загрузки будет сообщена при обращении к городу
+        }
+    }));
+}
+
+size_t CityRegistry::GetLoadedCount() const {
+    lock_guard guard(mutex_);
+    size_t count = 0;
+    for (const auto& [name, entry] : entries_) {
+        count += entry.loaded;
+    }
+    return count;
+}
+
+size_t CityRegistry::GetMemoryUsage() const {
+    lock_guard guard(mutex_);
+    return memory_;
+}
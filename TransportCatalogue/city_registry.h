@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "live_catalogue.h"
+#include "map_renderer.h"
+#include "request_handler.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+// Справочник одного города, загруженный из отдельной базы
+struct City {
+    City() = default;
+    City(const City&) = delete;
+    City& operator=(const City&) = delete;
+
+    TrC::TransportCatalogue catalogue;
+    renderer::MapRenderer renderer;
+    router::Graph graph;
+    RequestHandler handler{catalogue, renderer, graph};
+    router::TransportRouter router{catalogue, graph};
+    // Оценка занимаемой памяти, см. TransportCatalogue::GetMemoryUsage
+    size_t memory = 0;
+
+    // Загружает справочник из базы path и оценивает его память; false, если базу не удалось загрузить
+    bool Load(const std::string& path);
+
+    // Строит справочник base с изменениями update, а по нему - маршрутизатор и карту с настройками
+    // base. Бросает исключения TrC::ApplyUpdate, если изменения противоречат справочнику
+    void Build(const City& base, const TrC::CatalogueUpdate& update);
+
+private:
+    void EstimateMemory();
+};
+
+// Реестр справочников нескольких городов. Города загружаются при первом обращении, разные
+// города - параллельно, каждый не более одного раза. Если суммарная память загруженных
+// городов превышает бюджет, давно не использовавшиеся города, на которые никто не ссылается,
+// выгружаются и будут загружены повторно при следующем обращении
+class CityRegistry {
+public:
+    static constexpr size_t UNLIMITED = SIZE_MAX;
+
+    // bases - пути к базам городов по их названиям
+    explicit CityRegistry(std::map<std::string, std::string, std::less<>> bases, size_t memory_budget = UNLIMITED);
+    CityRegistry(const CityRegistry&) = delete;
+    CityRegistry& operator=(const CityRegistry&) = delete;
+    ~CityRegistry();
+
+    bool HasCity(std::string_view name) const {
+        return bases_.count(name);
+    }
+
+    // Загруженный справочник города; бросает std::out_of_range для неизвестного города
+    // и std::runtime_error, если базу не удалось загрузить. Ошибка загрузки запоминается
+    // до конца работы реестра: следующие обращения к городу бросают её, не читая базу снова
+    std::shared_ptr<City> Get(std::string_view name);
+
+    // Загружает города по порядку названий, пока их память не превысит бюджет, - например, чтобы
+    // дочерние процессы получили их уже загруженными, общими страницами памяти. Ошибки загрузки
+    // пишутся в stderr и запоминаются, как в Get
+    void Preload();
+
+    // Начинает загрузку города в фоне, не дожидаясь её окончания. Может вызываться из нескольких потоков
+    void Prefetch(std::string_view name);
+
+    size_t GetLoadedCount() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Entry {
+        std::shared_future<std::shared_ptr<City>> city;
+        uint64_t last_used = 0;
+        size_t memory = 0;
+        bool loaded = false;
+    };
+
+    std::shared_ptr<City> Load(const std::string& name) const;
+    void EvictLocked(std::string_view keep);
+
+    const std::map<std::string, std::string, std::less<>> bases_;
+    const size_t memory_budget_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Entry, std::less<>> entries_;
+    uint64_t clock_ = 0;
+    size_t memory_ = 0;
+    std::vector<std::future<void>> prefetches_;
+};
@@ -8,6 +8,7 @@
 #include <cmath>
 
 #include "geo.h"
+#include "flat_hash_map.h"
 
 namespace TrC {
 
@@ -19,9 +20,31 @@ struct Stop {
 std::istream& operator>>(std::istream& is, Stop& stop);
 
 struct Bus {
+    Bus() = default;
+    Bus(std::string bus_name, std::vector<Stop*> bus_route, bool ring)
+        : name(std::move(bus_name)), route(std::move(bus_route)), is_ring(ring) {
+    }
+    
     std::string name;        
     std::vector<Stop*> route;
     bool is_ring = false;
+    
+    // Префиксные суммы дорожных расстояний, заполняются при добавлении маршрута в справочник:
+    // forward_lengths[i] - путь от route[0] до route[i] в прямом направлении,
+    // backward_lengths[i] - путь от route[i] до route[0] в обратном направлении (только для некольцевых)
+    std::vector<unsigned> forward_lengths;
+    std::vector<unsigned> backward_lengths;
+    // Географическая длина маршрута в прямом направлении
+    double geo_length = 0;
+    
+    // Расстояние по маршруту между остановками с индексами from и to:
+    // при from < to - в прямом направлении, при from > to - в обратном
+    unsigned SpanDistance(size_t from, size_t to) const {
+        if (from <= to) {
+            return forward_lengths[to] - forward_lengths[from];
+        }
+        return backward_lengths[from] - backward_lengths[to];
+    }
 };
     
 bool operator<(const Bus& lbs, const Bus& rbs);
@@ -37,7 +60,7 @@ namespace detail {
     
 struct PairHash {
     size_t operator() (const std::pair<Stop*, Stop*>& p) const {
-        return p_hash_(p.first) * static_cast<size_t>(std::pow(59, 4)) + p_hash_(p.second) * 59;
+        return flat::HashCombine(p_hash_(p.first), p_hash_(p.second));
     } 
 private:
     std::hash<const void*> p_hash_;
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace flat {
+
+// Финализатор splitmix64: равномерно перемешивает все биты хэша,
+// в том числе для std::hash от указателей, который возвращает сам адрес
+inline uint64_t Mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline uint64_t HashCombine(uint64_t seed, uint64_t value) {
+    return Mix(seed ^ (Mix(value) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+// Хэш-таблица с открытой адресацией и линейным пробированием.
+// Пары ключ-значение хранятся подряд в векторе в порядке вставки,
+// а таблица слотов содержит только индексы в этот вектор и старшие биты хэша.
+// Итераторы произвольного доступа, поэтому позиция элемента (distance от begin)
+// совпадает с порядком его добавления и вычисляется за O(1).
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class HashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    HashMap() = default;
+
+    iterator begin() {
+        return entries_.begin();
+    }
+    iterator end() {
+        return entries_.end();
+    }
+    const_iterator begin() const {
+        return entries_.cbegin();
+    }
+    const_iterator end() const {
+        return entries_.cend();
+    }
+
+    size_t size() const {
+        return entries_.size();
+    }
+    bool empty() const {
+        return entries_.empty();
+    }
+
+    void reserve(size_t count) {
+        entries_.reserve(count);
+        size_t capacity = MIN_CAPACITY;
+        while (capacity * MAX_LOAD_NUM < count * MAX_LOAD_DEN) {
+            capacity *= 2;
+        }
+        if (capacity > slots_.size()) {
+            Rehash(capacity);
+        }
+    }
+
+    void clear() {
+        entries_.clear();
+        slots_.clear();
+    }
+
+    iterator find(const Key& key) {
+        const size_t pos = FindIndex(key);
+        return pos == NPOS ? entries_.end() : entries_.begin() + pos;
+    }
+    const_iterator find(const Key& key) const {
+        const size_t pos = FindIndex(key);
+        return pos == NPOS ? entries_.cend() : entries_.cbegin() + pos;
+    }
+
+    size_t count(const Key& key) const {
+        return FindIndex(key) == NPOS ? 0 : 1;
+    }
+
+    Value& at(const Key& key) {
+        const size_t pos = FindIndex(key);
+        if (pos == NPOS) {
+            throw std::out_of_range("flat::HashMap::at");
+        }
+        return entries_[pos].second;
+    }
+    const Value& at(const Key& key) const {
+        const size_t pos = FindIndex(key);
+        if (pos == NPOS) {
+            throw std::out_of_range("flat::HashMap::at");
+        }
+        return entries_[pos].second;
+    }
+
+    Value& operator[](const Key& key) {
+        return try_emplace(key).first->second;
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        const uint64_t hash = HashOf(key);
+        if (!slots_.empty()) {
+            const size_t pos = FindIndex(key, hash);
+            if (pos != NPOS) {
+                return {entries_.begin() + pos, false};
+            }
+        }
+        if ((entries_.size() + 1) * MAX_LOAD_DEN > slots_.size() * MAX_LOAD_NUM) {
+            Rehash(slots_.empty() ? MIN_CAPACITY : slots_.size() * 2);
+        }
+        entries_.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+        InsertSlot(hash, static_cast<uint32_t>(entries_.size() - 1));
+        return {entries_.end() - 1, true};
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) {
+        return try_emplace(value.first, value.second);
+    }
+
+    // Объём памяти, занятый таблицей, без учёта данных, на которые ссылаются ключи и значения
+    size_t GetMemoryUsage() const {
+        return entries_.capacity() * sizeof(value_type) + slots_.capacity() * sizeof(Slot);
+    }
+
+private:
+    struct Slot {
+        uint32_t index = EMPTY;
+        uint32_t tag = 0;
+    };
+
+    static constexpr uint32_t EMPTY = UINT32_MAX;
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+    static constexpr size_t MIN_CAPACITY = 16;
+    // Максимальная заполненность таблицы слотов — 3/4
+    static constexpr size_t MAX_LOAD_NUM = 3;
+    static constexpr size_t MAX_LOAD_DEN = 4;
+
+    uint64_t HashOf(const Key& key) const {
+        return Mix(static_cast<uint64_t>(hasher_(key)));
+    }
+
+    size_t FindIndex(const Key& key) const {
+        if (slots_.empty()) {
+            return NPOS;
+        }
+        return FindIndex(key, HashOf(key));
+    }
+
+    size_t FindIndex(const Key& key, uint64_t hash) const {
+        const size_t mask = slots_.size() - 1;
+        const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const Slot& slot = slots_[i];
+            if (slot.index == EMPTY) {
+                return NPOS;
+            }
+            if (slot.tag == tag && equal_(entries_[slot.index].first, key)) {
+                return slot.index;
+            }
+        }
+    }
+
+    void InsertSlot(uint64_t hash, uint32_t index) {
+        const size_t mask = slots_.size() - 1;
+        size_t i = hash & mask;
+        while (slots_[i].index != EMPTY) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = {index, static_cast<uint32_t>(hash >> 32)};
+    }
+
+    void Rehash(size_t capacity) {
+        slots_.assign(capacity, Slot{});
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            InsertSlot(HashOf(entries_[i].first), static_cast<uint32_t>(i));
+        }
+    }
+
+    std::vector<value_type> entries_;
+    std::vector<Slot> slots_;
+    Hash hasher_;
+    KeyEqual equal_;
+};
+
+} // namespace flat
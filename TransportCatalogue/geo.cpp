@@ -1,10 +1,160 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace geo {
 
+namespace {
+
+const double DR = M_PI / 180.;
+
+// Для |x| <= POLY_LIMIT отрезки рядов ниже дают погрешность порядка машинного эпсилон
+const double POLY_LIMIT = 0.1;
+const double ASIN_LIMIT = 0.15;
+
+// Коэффициенты рядов Тейлора при x, x^3, x^5, ...: sin(x) до x^11 и asin(s) до s^21
+const double SIN_COEFFS[] = {1., -1. / 6, 1. / 120, -1. / 5040, 1. / 362880, -1. / 39916800};
+const double ASIN_COEFFS[] = {1., 1. / 6, 3. / 40, 5. / 112, 35. / 1152, 63. / 2816, 231. / 13312,
+                              143. / 10240, 6435. / 557056, 12155. / 1245184, 46189. / 5505024};
+
+// Операции над одним числом; векторные варианты (Batch) задают те же функции через интринсики,
+// поэтому полиномы вычисляются одним кодом и не зависят от операторов над векторными типами
+struct Scalar {
+    using V = double;
+    
+    static V Set(double x) { return x; }
+    static V Add(V a, V b) { return a + b; }
+    static V Mul(V a, V b) { return a * b; }
+};
+
+// Нечётный полином x * (c[0] + c[1] x^2 + c[2] x^4 + ...) по схеме Горнера
+template <typename Ops, size_t N>
+typename Ops::V OddPoly(typename Ops::V x, const double (&coeffs)[N]) {
+    const typename Ops::V x2 = Ops::Mul(x, x);
+    typename Ops::V sum = Ops::Set(coeffs[N - 1]);
+    for (size_t i = N - 1; i > 0; --i) {
+        sum = Ops::Add(Ops::Set(coeffs[i - 1]), Ops::Mul(x2, sum));
+    }
+    return Ops::Mul(x, sum);
+}
+
+template <typename Ops = Scalar>
+typename Ops::V SinPoly(typename Ops::V x) {
+    return OddPoly<Ops>(x, SIN_COEFFS);
+}
+
+template <typename Ops = Scalar>
+typename Ops::V AsinPoly(typename Ops::V s) {
+    return OddPoly<Ops>(s, ASIN_COEFFS);
+}
+
+// Центральный угол по формуле гаверсинусов
+double PreciseAngle(double dlat, double dlng, double cos_cos) {
+    const double a = std::sin(dlat / 2);
+    const double b = std::sin(dlng / 2);
+    const double h = std::min(1., a * a + cos_cos * b * b);
+    return 2 * std::asin(std::sqrt(h));
+}
+
+double Angle(double dlat, double dlng, double cos_cos) {
+    if (std::abs(dlat / 2) > POLY_LIMIT || std::abs(dlng / 2) > POLY_LIMIT) {
+        return PreciseAngle(dlat, dlng, cos_cos);
+    }
+    const double a = SinPoly(dlat / 2);
+    const double b = SinPoly(dlng / 2);
+    const double s = std::sqrt(a * a + cos_cos * b * b);
+    return s > ASIN_LIMIT ? PreciseAngle(dlat, dlng, cos_cos) : 2 * AsinPoly(s);
+}
+
+#if defined(__AVX__)
+
+struct Batch {
+    using V = __m256d;
+    static const size_t WIDTH = 4;
+    
+    static V Load(const double* p) { return _mm256_loadu_pd(p); }
+    static void Store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static V Set(double x) { return _mm256_set1_pd(x); }
+    static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V Sqrt(V v) { return _mm256_sqrt_pd(v); }
+    static V Abs(V v) { return _mm256_andnot_pd(_mm256_set1_pd(-0.), v); }
+    // Истина, если все элементы a не больше соответствующих элементов b
+    static bool AllLessEqual(V a, V b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LE_OQ)) == 0xF; }
+};
+
+#elif defined(__SSE2__)
+
+struct Batch {
+    using V = __m128d;
+    static const size_t WIDTH = 2;
+    
+    static V Load(const double* p) { return _mm_loadu_pd(p); }
+    static void Store(double* p, V v) { _mm_storeu_pd(p, v); }
+    static V Set(double x) { return _mm_set1_pd(x); }
+    static V Add(V a, V b) { return _mm_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V Sqrt(V v) { return _mm_sqrt_pd(v); }
+    static V Abs(V v) { return _mm_andnot_pd(_mm_set1_pd(-0.), v); }
+    static bool AllLessEqual(V a, V b) { return _mm_movemask_pd(_mm_cmple_pd(a, b)) == 0x3; }
+};
+
+#endif
+
+// Центральные углы между парами (lat1[i], lng1[i]) - (lat2[i], lng2[i]), i в [0, count).
+// Если FixedFirst, первая точка одна и та же для всех пар и берётся из lat1[0], lng1[0]
+template <bool FixedFirst>
+void ComputeAngles(size_t count, const double* lat1, const double* lng1, const double* cos1,
+                   const double* lat2, const double* lng2, const double* cos2, double* out) {
+    size_t i = 0;
+#if defined(__AVX__) || defined(__SSE2__)
+    using V = Batch::V;
+    const V half = Batch::Set(0.5);
+    const V two = Batch::Set(2.);
+    const V limit = Batch::Set(POLY_LIMIT);
+    const V asin_limit = Batch::Set(ASIN_LIMIT);
+    for (; i + Batch::WIDTH <= count; i += Batch::WIDTH) {
+        const size_t j = FixedFirst ? 0 : i;
+        const V la1 = FixedFirst ? Batch::Set(lat1[0]) : Batch::Load(lat1 + j);
+        const V ln1 = FixedFirst ? Batch::Set(lng1[0]) : Batch::Load(lng1 + j);
+        const V c1 = FixedFirst ? Batch::Set(cos1[0]) : Batch::Load(cos1 + j);
+        const V half_dlat = Batch::Mul(Batch::Sub(Batch::Load(lat2 + i), la1), half);
+        const V half_dlng = Batch::Mul(Batch::Sub(Batch::Load(lng2 + i), ln1), half);
+        const V cos_cos = Batch::Mul(c1, Batch::Load(cos2 + i));
+        
+        const V a = SinPoly<Batch>(half_dlat);
+        const V b = SinPoly<Batch>(half_dlng);
+        const V s = Batch::Sqrt(Batch::Add(Batch::Mul(a, a), Batch::Mul(Batch::Mul(cos_cos, b), b)));
+        Batch::Store(out + i, Batch::Mul(AsinPoly<Batch>(s), two));
+        
+        // Пары вне области применимости полиномов пересчитываются точно
+        if (!Batch::AllLessEqual(Batch::Abs(half_dlat), limit) || !Batch::AllLessEqual(Batch::Abs(half_dlng), limit)
+            || !Batch::AllLessEqual(s, asin_limit)) {
+            for (size_t k = i; k < i + Batch::WIDTH; ++k) {
+                const size_t m = FixedFirst ? 0 : k;
+                out[k] = Angle(lat2[k] - lat1[m], lng2[k] - lng1[m], cos1[m] * cos2[k]);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const size_t m = FixedFirst ? 0 : i;
+        out[i] = Angle(lat2[i] - lat1[m], lng2[i] - lng1[m], cos1[m] * cos2[i]);
+    }
+}
+
+} // namespace
+
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
     if (from == to) {
@@ -13,7 +163,52 @@ double ComputeDistance(Coordinates from, Coordinates to) {
     static const double dr = M_PI / 180.;
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * 6371000;
+        * EARTH_RADIUS;
+}
+
+PointsArray::PointsArray(const std::vector<Coordinates>& points) {
+    Reserve(points.size());
+    for (const Coordinates point : points) {
+        Add(point);
+    }
+}
+
+void PointsArray::Reserve(size_t count) {
+    lat.reserve(count);
+    lng.reserve(count);
+    cos_lat.reserve(count);
+}
+
+void PointsArray::Add(Coordinates point) {
+    lat.push_back(point.lat * DR);
+    lng.push_back(point.lng * DR);
+    cos_lat.push_back(std::cos(lat.back()));
+}
+
+void ComputeDistances(Coordinates from, const PointsArray& points, size_t begin, size_t end, double* out) {
+    const double lat = from.lat * DR;
+    const double lng = from.lng * DR;
+    const double cos_lat = std::cos(lat);
+    ComputeAngles<true>(end - begin, &lat, &lng, &cos_lat, points.lat.data() + begin, 
+                        points.lng.data() + begin, points.cos_lat.data() + begin, out);
+    for (size_t i = 0; i < end - begin; ++i) {
+        out[i] *= EARTH_RADIUS;
+    }
+}
+
+double ComputeLength(const PointsArray& points) {
+    if (points.Size() < 2) {
+        return 0;
+    }
+    const size_t count = points.Size() - 1;
+    std::vector<double> angles(count);
+    ComputeAngles<false>(count, points.lat.data(), points.lng.data(), points.cos_lat.data(),
+                         points.lat.data() + 1, points.lng.data() + 1, points.cos_lat.data() + 1, angles.data());
+    double length = 0;
+    for (const double angle : angles) {
+        length += angle;
+    }
+    return length * EARTH_RADIUS;
 }
 
-}  // namespace geo
\ No newline at end of file
+}  // namespace geo
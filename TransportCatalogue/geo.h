@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 namespace geo {
 
+inline const double EARTH_RADIUS = 6371000;
+
 struct Coordinates {
     double lat; // Широта
     double lng; // Долгота
@@ -15,4 +20,30 @@ struct Coordinates {
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
-}  // namespace geo
\ No newline at end of file
+// Набор точек в виде структуры массивов для пакетного вычисления расстояний:
+// координаты в радианах и заранее вычисленный косинус широты
+struct PointsArray {
+    std::vector<double> lat;
+    std::vector<double> lng;
+    std::vector<double> cos_lat;
+    
+    PointsArray() = default;
+    explicit PointsArray(const std::vector<Coordinates>& points);
+    
+    void Reserve(size_t count);
+    void Add(Coordinates point);
+    
+    size_t Size() const {
+        return lat.size();
+    }
+};
+
+// Расстояния (в метрах) от from до точек points с индексами [begin, end), записываются в out.
+// Для близких точек используются полиномиальные приближения, вычисляемые векторно,
+// для далёких - точная формула гаверсинусов
+void ComputeDistances(Coordinates from, const PointsArray& points, size_t begin, size_t end, double* out);
+
+// Длина ломаной, последовательно проходящей через все точки points
+double ComputeLength(const PointsArray& points);
+
+}  // namespace geo
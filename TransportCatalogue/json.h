@@ -1,16 +1,86 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
+// Массивы и словари могут размещаться в арене документа (см. Document)
+using Array = std::pmr::vector<Node>;
+
+// Словарь, хранящий пары в векторе, отсортированном по ключу. Интерфейс повторяет std::map
+// в той части, которой пользуются клиенты; поиск двоичный и принимает string_view.
+// Ключи элементов менять нельзя - это нарушит порядок
+class Dict {
+public:
+    using key_type = std::string;
+    using mapped_type = Node;
+    using value_type = std::pair<std::string, Node>;
+    using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+    using iterator = std::pmr::vector<value_type>::iterator;
+    using const_iterator = std::pmr::vector<value_type>::const_iterator;
+
+    Dict() = default;
+    explicit Dict(const allocator_type& alloc) : items_(alloc) {
+    }
+
+    iterator begin() {
+        return items_.begin();
+    }
+    iterator end() {
+        return items_.end();
+    }
+    const_iterator begin() const {
+        return items_.begin();
+    }
+    const_iterator end() const {
+        return items_.end();
+    }
+
+    size_t size() const {
+        return items_.size();
+    }
+    bool empty() const {
+        return items_.empty();
+    }
+    size_t capacity() const {
+        return items_.capacity();
+    }
+    void reserve(size_t count) {
+        items_.reserve(count);
+    }
+
+    iterator find(std::string_view key);
+    const_iterator find(std::string_view key) const;
+    size_t count(std::string_view key) const;
+    Node& at(std::string_view key);
+    const Node& at(std::string_view key) const;
+    Node& operator[](std::string key);
+
+    // Как у std::map: если ключ уже есть, значение не создаётся и second == false
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(std::string key, Args&&... args);
+
+    bool operator==(const Dict& rhs) const;
+    bool operator!=(const Dict& rhs) const {
+        return !(*this == rhs);
+    }
+
+private:
+    iterator LowerBound(std::string_view key);
+
+    std::pmr::vector<value_type> items_;
+};
 
 class ParsingError : public std::runtime_error {
 public:
@@ -146,17 +216,79 @@ inline bool operator!=(const Node& lhs, const Node& rhs) {
     return !(lhs == rhs);
 }
 
+inline Dict::iterator Dict::LowerBound(std::string_view key) {
+    return std::lower_bound(items_.begin(), items_.end(), key, [](const value_type& item, std::string_view key) {
+        return item.first < key;
+    });
+}
+
+inline Dict::iterator Dict::find(std::string_view key) {
+    const auto it = LowerBound(key);
+    return it != items_.end() && it->first == key ? it : items_.end();
+}
+
+inline Dict::const_iterator Dict::find(std::string_view key) const {
+    return const_cast<Dict&>(*this).find(key);
+}
+
+inline size_t Dict::count(std::string_view key) const {
+    return find(key) != end() ? 1 : 0;
+}
+
+inline Node& Dict::at(std::string_view key) {
+    const auto it = find(key);
+    if (it == items_.end()) {
+        throw std::out_of_range("Dict::at");
+    }
+    return it->second;
+}
+
+inline const Node& Dict::at(std::string_view key) const {
+    return const_cast<Dict&>(*this).at(key);
+}
+
+inline Node& Dict::operator[](std::string key) {
+    return try_emplace(std::move(key)).first->second;
+}
+
+template <typename... Args>
+std::pair<Dict::iterator, bool> Dict::try_emplace(std::string key, Args&&... args) {
+    // Ключи разобранного документа часто идут по возрастанию - тогда вставка в конец
+    auto it = items_.empty() || items_.back().first < key ? items_.end() : LowerBound(key);
+    if (it != items_.end() && it->first == key) {
+        return {it, false};
+    }
+    it = items_.emplace(it, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+    return {it, true};
+}
+
+inline bool Dict::operator==(const Dict& rhs) const {
+    return std::equal(items_.begin(), items_.end(), rhs.items_.begin(), rhs.items_.end());
+}
+
+// Арена, из которой выделяется память массивов и словарей разобранного документа.
+// Память возвращается одним куском при уничтожении документа
+using Arena = std::pmr::monotonic_buffer_resource;
+
 class Document {
 public:
     explicit Document(Node root)
         : root_(std::move(root)) {
     }
 
+    // Узлы root могут ссылаться на память arena, поэтому документ владеет ею
+    Document(std::unique_ptr<Arena> arena, Node root)
+        : arena_(std::move(arena)), root_(std::move(root)) {
+    }
+
     const Node& GetRoot() const {
         return root_;
     }
 
 private:
+    // Объявлена раньше корня, чтобы освобождаться после него
+    std::unique_ptr<Arena> arena_;
     Node root_;
 };
 
@@ -170,6 +302,15 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
 
 Document Load(std::istream& input);
 
-void Print(const Document& doc, std::ostream& output);
+// Разбирает документ из буфера в памяти; буфер нужен только на время разбора
+Document Load(std::string_view input);
+
+// PRETTY - каждый элемент с новой строки с отступом в 4 пробела, COMPACT - без пробельных символов
+enum class Format {
+    PRETTY,
+    COMPACT,
+};
+
+void Print(const Document& doc, std::ostream& output, Format format = Format::PRETTY);
 
 }  // namespace json
\ No newline at end of file
@@ -9,10 +9,10 @@ using namespace std;
 namespace json {
     
 KeyItemContext Builder::Key(const std::string& str) {
-    if (is_begin || !(nodes_stack_.size() && nodes_stack_.back()->IsDict())) {
+    if (is_begin || !(nodes_stack_.size() && nodes_stack_.back().IsDict())) {
         throw logic_error("error Key method ");
     }
-    nodes_stack_.push_back(new Node(str));
+    nodes_stack_.emplace_back(str);
     return KeyItemContext(*this);
 }
 
@@ -20,57 +20,60 @@ Builder& Builder::Value(const Node& node) {
     if (is_begin) {
         throw logic_error("error Value method ");
     }
-    
+    return AddNode(node);
+}
+
+Builder& Builder::AddNode(Node node) {
     if (nodes_stack_.empty()) {
-        root_ = node;
+        root_ = move(node);
         is_begin = true;
         return *this;
     }
-    else if (nodes_stack_.back()->IsArray()) {
-        nodes_stack_.back()->AsArray().push_back(node);
+    else if (nodes_stack_.back().IsArray()) {
+        nodes_stack_.back().AsArray().push_back(move(node));
         return *this;
     }
     else {
-        nodes_stack_[nodes_stack_.size()-2]->AsDict()[move(nodes_stack_.back()->AsString())] = node;
+        nodes_stack_[nodes_stack_.size()-2].AsDict()[nodes_stack_.back().AsString()] = move(node);
         nodes_stack_.pop_back();
         return *this;
     }
 }
     
 DictItemContext Builder::StartDict() {
-    if (is_begin || (!nodes_stack_.empty() && (!nodes_stack_.back()->IsArray() &&
-        !nodes_stack_.back()->IsString()))) {
+    if (is_begin || (!nodes_stack_.empty() && (!nodes_stack_.back().IsArray() &&
+        !nodes_stack_.back().IsString()))) {
         throw logic_error("error StartDict method ");
     }
-    nodes_stack_.push_back(new Node(Dict()));
+    nodes_stack_.emplace_back(Dict());
     return DictItemContext(*this);
 }
     
 ArrayItemContext Builder::StartArray() {
-    if (is_begin || (!nodes_stack_.empty() && (!nodes_stack_.back()->IsArray() &&
-        !nodes_stack_.back()->IsString()))) {
+    if (is_begin || (!nodes_stack_.empty() && (!nodes_stack_.back().IsArray() &&
+        !nodes_stack_.back().IsString()))) {
         throw logic_error("error StartArray method ");
     }
-    nodes_stack_.push_back(new Node(Array()));
+    nodes_stack_.emplace_back(Array());
     return ArrayItemContext(*this);
 }
     
 Builder& Builder::EndDict() {
-    if (is_begin || nodes_stack_.empty() || !nodes_stack_.back()->IsDict()) {
+    if (is_begin || nodes_stack_.empty() || !nodes_stack_.back().IsDict()) {
         throw logic_error("error EndDict method ");
     }
-    Node node = move(*(nodes_stack_.back()));
+    Node node = move(nodes_stack_.back());
     nodes_stack_.pop_back();
-    return Value(node);
+    return AddNode(move(node));
 }
     
 Builder& Builder::EndArray() {
-    if (is_begin || nodes_stack_.empty() || !nodes_stack_.back()->IsArray()) {
+    if (is_begin || nodes_stack_.empty() || !nodes_stack_.back().IsArray()) {
         throw logic_error("error EndArray method ");
     }
-    Node node = move(*(nodes_stack_.back()));
+    Node node = move(nodes_stack_.back());
     nodes_stack_.pop_back();
-    return Value(node);
+    return AddNode(move(node));
 }
     
 Node Builder::Build() {
@@ -91,8 +94,8 @@ Builder& DictItemContext::EndDict() {
     
     
 DictItemContext KeyItemContext::Value(const Node& node) {
-    std::vector<Node*>& stack = builder_.GetStack();
-    stack[stack.size()-2]->AsDict()[move(stack.back()->AsString())] = node;
+    std::vector<Node>& stack = builder_.GetStack();
+    stack[stack.size()-2].AsDict()[stack.back().AsString()] = node;
     stack.pop_back();
     return DictItemContext(builder_);
 }
@@ -107,7 +110,7 @@ ArrayItemContext KeyItemContext::StartArray() {
     
     
 ArrayItemContext& ArrayItemContext::Value(const Node& node) {
-    builder_.GetStack().back()->AsArray().push_back(node);
+    builder_.GetStack().back().AsArray().push_back(node);
     return *this;
 }
     
@@ -32,15 +32,20 @@ public:
     
     Node Build();
     
-    std::vector<Node*>& GetStack() {
+    std::vector<Node>& GetStack() {
         return nodes_stack_;
     }
-    const std::vector<Node*>& GetStack() const {
+    const std::vector<Node>& GetStack() const {
         return nodes_stack_;
     }
 private:
+    // Добавляет законченный узел в открытый контейнер или делает его корнем
+    Builder& AddNode(Node node);
+    
     Node root_;
-    std::vector<Node*> nodes_stack_;
+    // Открытые контейнеры и ключи хранятся по значению: ссылки на них не сохраняются,
+    // поэтому перераспределение стека безопасно
+    std::vector<Node> nodes_stack_;
     bool is_begin = false;
 };
     
@@ -1,5 +1,13 @@
 #include "json_reader.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <tuple>
+
+#include "parallel.h"
+
 using namespace std;
 
 svg::Color ToColor(const json::Node& node) {
@@ -15,47 +23,333 @@ svg::Color ToColor(const json::Node& node) {
     return node.AsString();
 }
 
-TrC::Stop JsonReader::MakeStop(const json::Dict& stop) const {
-    return {stop.at("name"s).AsString(), 
-            {stop.at("latitude"s).AsDouble(), stop.at("longitude"s).AsDouble()}};
-}
+namespace {
 
-TrC::Bus JsonReader::MakeBus(const RequestHandler& handler, const json::Dict& bus) const {
-    vector<TrC::Stop*> stops;
-    for (const auto& name : bus.at("stops"s).AsArray()) {
-        stops.push_back(&handler.GetStop(name.AsString()));
-    }
+// Меньше запросов на поток не делится: запуск потока дороже их обработки
+const size_t MIN_REQUESTS_CHUNK = 4096;
+const size_t MIN_BUSES_CHUNK = 256;
+// Ответы на stat_requests вычисляются с опережением записи не более чем на столько
+// запросов на поток: память не растёт с числом запросов, а потоки не ждут медленный запрос
+const size_t REPORTS_WINDOW_PER_THREAD = 4;
 
-    return {bus.at("name"s).AsString(), stops, bus.at("is_roundtrip"s).AsBool()};
-}
+// Обработчик потокового разбора запроса make_base. Каждый элемент base_requests разбирается
+// декодером схемы запроса и сразу обрабатывается, остальные разделы корневого словаря
+// сохраняются целиком
+class BaseRequestsLoader final : public json::SaxHandler {
+public:
+    using OnRequest = function<void(requests::BaseRequest&)>;
+    
+    explicit BaseRequestsLoader(OnRequest on_request) : on_request_(move(on_request)) {
+    }
+    
+    void StartDict() override {
+        if (decoding_) {
+            decoder_.StartDict();
+        }
+        else if (depth_ == REQUEST_DEPTH && in_requests_) {
+            decoding_ = true;
+            decoder_.StartDict();
+        }
+        else {
+            Open(true);
+        }
+    }
+    
+    void EndDict() override {
+        if (!decoding_) {
+            Close(true);
+            return;
+        }
+        decoder_.EndDict();
+        if (decoder_.IsComplete()) {
+            decoding_ = false;
+            requests::BaseRequest request = decoder_.Extract();
+            on_request_(request);
+        }
+    }
+    
+    void StartArray() override {
+        if (decoding_) {
+            decoder_.StartArray();
+        }
+        else {
+            Open(false);
+        }
+    }
+    
+    void EndArray() override {
+        if (decoding_) {
+            decoder_.EndArray();
+        }
+        else {
+            Close(false);
+        }
+    }
+    
+    void Key(string_view key) override {
+        if (decoding_) {
+            decoder_.Key(key);
+        }
+        else if (builder_) {
+            builder_->Key(key);
+        }
+        else {
+            key_ = key;
+        }
+    }
+    
+    void Value(nullptr_t value) override {
+        decoding_ ? decoder_.Value(value) : AddValue(value);
+    }
+    
+    void Value(bool value) override {
+        decoding_ ? decoder_.Value(value) : AddValue(value);
+    }
+    
+    void Value(int value) override {
+        decoding_ ? decoder_.Value(value) : AddValue(value);
+    }
+    
+    void Value(double value) override {
+        decoding_ ? decoder_.Value(value) : AddValue(value);
+    }
+    
+    void Value(string_view value) override {
+        decoding_ ? decoder_.Value(value) : AddValue(value);
+    }
+    
+    // Разделы документа, кроме base_requests
+    json::Dict ExtractSections() {
+        return move(sections_);
+    }
+    
+private:
+    // Глубина вложенности значений разделов корневого словаря и элементов base_requests
+    static constexpr size_t SECTION_DEPTH = 1;
+    static constexpr size_t REQUEST_DEPTH = 2;
+    
+    void Open(bool is_dict) {
+        if (!builder_) {
+            if (depth_ == 0 && !is_dict) {
+                throw json::ParsingError("Request must be a dictionary"s);
+            }
+            if (depth_ == SECTION_DEPTH && key_ == "base_requests"s && !is_dict) {
+                in_requests_ = true;
+            }
+            else if (depth_ == SECTION_DEPTH) {
+                builder_.emplace();
+                builder_depth_ = depth_;
+            }
+        }
+        if (builder_) {
+            is_dict ? builder_->StartDict() : builder_->StartArray();
+        }
+        ++depth_;
+    }
+    
+    void Close(bool is_dict) {
+        --depth_;
+        if (!builder_) {
+            // Закрылся массив base_requests или корневой словарь
+            in_requests_ = false;
+            return;
+        }
+        is_dict ? builder_->EndDict() : builder_->EndArray();
+        if (depth_ != builder_depth_) {
+            return;
+        }
+        AddSection(builder_->Build());
+        builder_.reset();
+    }
+    
+    template <typename Value>
+    void AddValue(Value value) {
+        if (builder_) {
+            builder_->Value(value);
+        }
+        else if (depth_ == SECTION_DEPTH) {
+            if constexpr (is_same_v<Value, string_view>) {
+                AddSection(json::Node(string(value)));
+            }
+            else {
+                AddSection(json::Node(value));
+            }
+        }
+        else {
+            throw json::ParsingError("Base request must be a dictionary"s);
+        }
+    }
+    
+    void AddSection(json::Node node) {
+        if (!sections_.try_emplace(key_, move(node)).second) {
+            throw json::ParsingError("Duplicate key '"s + key_ + "' have been found");
+        }
+    }
+    
+    OnRequest on_request_;
+    json::Dict sections_;
+    string key_;
+    size_t depth_ = 0;
+    bool in_requests_ = false;
+    optional<json::NodeBuilder> builder_;
+    size_t builder_depth_ = 0;
+    requests::BaseRequestDecoder decoder_;
+    bool decoding_ = false;
+};
 
-pair<TrC::Stop*, vector<TrC::detail::DistanceToStop>> JsonReader::
-MakeDistances(const RequestHandler& handler, const json::Dict& stop) const {
-    vector<TrC::detail::DistanceToStop> distances;
-    for (const auto& [key, value] : stop.at("road_distances"s).AsDict()) {
-        distances.push_back({static_cast<unsigned>(value.AsInt()), key});
+// Разобранные base_requests, остановки которых уже добавлены в справочник: расстояния
+// и маршруты ждут, пока станут известны все остановки
+struct PendingRequests {
+    // Маршрут, ожидающий добавления всех остановок
+    struct Bus {
+        string name;
+        vector<string> stops;
+        bool is_ring = false;
+    };
+    
+    vector<pair<TrC::Stop*, vector<TrC::detail::DistanceToStop>>> distances;
+    vector<Bus> buses;
+    
+    void Add(requests::BaseRequest& request, TrC::TransportCatalogue& catalogue) {
+        if (request.type == requests::BaseRequest::Type::STOP) {
+            TrC::Stop& stop = catalogue.AddStop(TrC::Stop{move(request.name), request.coordinates});
+            distances.emplace_back(&stop, move(request.road_distances));
+        }
+        else if (request.type == requests::BaseRequest::Type::BUS) {
+            buses.push_back(Bus{move(request.name), move(request.stops), request.is_roundtrip});
+        }
     }
-    return {&handler.GetStop(stop.at("name"s).AsString()), distances};
-}
+};
 
-void JsonReader::FillingCatalogue(TrC::TransportCatalogue& catalogue, const RequestHandler& handler) const {
-    for(const auto& value : querys_.GetRoot().AsDict().at("base_requests"s).AsArray()) {
-        if (value.AsDict().at("type"s).AsString() == "Stop"s) {
-            catalogue.AddStop(MakeStop(value.AsDict()));
+// Добавляет в справочник расстояния и маршруты. Имена остановок разрешаются по частям
+// параллельно, результаты добавляются в порядке запросов; индексы строятся одновременно
+void AddPendingRequests(PendingRequests& pending, TrC::TransportCatalogue& catalogue,
+                        const RequestHandler& handler) {
+    const TrC::StopsIndex& names = catalogue.GetStops();
+    auto distances = parallel::MapChunks(pending.distances.size(), [&](size_t begin, size_t end) {
+        vector<tuple<TrC::Stop*, TrC::Stop*, unsigned>> resolved;
+        for (size_t i = begin; i < end; ++i) {
+            auto& [from, stop_distances] = pending.distances[i];
+            for (const auto& distance : stop_distances) {
+                // Расстояние до неизвестной остановки пропускается
+                if (const auto it = names.find(distance.stop_name); it != names.end()) {
+                    resolved.emplace_back(from, it->second, distance.distance);
+                }
+            }
+            stop_distances = {};
         }
+        return resolved;
+    }, MIN_REQUESTS_CHUNK);
+    pending.distances = {};
+    for (auto& chunk : distances) {
+        for (const auto& [from, to, distance] : chunk) {
+            catalogue.AddDistances(from, to, distance);
+        }
+        chunk = {};
     }
     
-    for(const auto& value : querys_.GetRoot().AsDict().at("base_requests"s).AsArray()) {
-        if (value.AsDict().at("type"s).AsString() == "Bus"s) {
-            catalogue.AddBus(MakeBus(handler, value.AsDict()));
+    auto buses = parallel::MapChunks(pending.buses.size(), [&](size_t begin, size_t end) {
+        vector<TrC::Bus> resolved;
+        resolved.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            auto& bus = pending.buses[i];
+            vector<TrC::Stop*> stops;
+            stops.reserve(bus.stops.size());
+            for (const auto& name : bus.stops) {
+                stops.push_back(&handler.GetStop(name));
+            }
+            resolved.push_back(TrC::Bus{move(bus.name), move(stops), bus.is_ring});
+            bus.stops = {};
         }
+        return resolved;
+    }, MIN_BUSES_CHUNK);
+    pending.buses = {};
+    vector<TrC::Bus> all_buses;
+    for (auto& chunk : buses) {
+        move(chunk.begin(), chunk.end(), back_inserter(all_buses));
+    }
+    buses.clear();
+    catalogue.AddBuses(move(all_buses));
+    
+    parallel::Invoke([&catalogue] { catalogue.BuildBusesForStopsIndex(); },
+                     [&catalogue] { catalogue.BuildSpatialIndex(); },
+                     [&catalogue] { catalogue.BuildNameIndex(); });
+}
+
+} // namespace
+
+void JsonReader::FillingCatalogue(istream& input, TrC::TransportCatalogue& catalogue, const RequestHandler& handler) {
+    LoadBaseRequests([&input](json::SaxHandler& loader) {
+        json::Parse(input, loader);
+    }, catalogue, handler);
+}
+
+void JsonReader::FillingCatalogue(string_view input, TrC::TransportCatalogue& catalogue, 
+                                  const RequestHandler& handler) {
+    // В одном потоке документ разбирается за один проход, без предварительного деления;
+    // так же разбирается документ, который не является словарём, чтобы сообщить об ошибке
+    const size_t root = input.find_first_not_of(" \t\n\r"sv);
+    if (parallel::GetThreadCount() == 1 || root == input.npos || input[root] != '{') {
+        LoadBaseRequests([input](json::SaxHandler& loader) {
+            json::Parse(input, loader);
+        }, catalogue, handler);
+        return;
     }
     
-    for(const auto& value : querys_.GetRoot().AsDict().at("base_requests"s).AsArray()) {
-        if (value.AsDict().at("type"s).AsString() == "Stop"s) {
-            catalogue.AddDistances(MakeDistances(handler, value.AsDict()));
+    // Элементы base_requests находятся без разбора, остальные разделы разбираются как обычно.
+    // Документ с base_requests другого вида разбирается целиком, как в одном потоке
+    const vector<json::Member> members = json::SplitDict(input);
+    const auto is_base = [](const json::Member& member) {
+        return member.key == "base_requests"s;
+    };
+    const auto base_requests = find_if(members.begin(), members.end(), is_base);
+    if (base_requests == members.end() || base_requests->value.empty() || base_requests->value.front() != '['
+        || count_if(base_requests, members.end(), is_base) != 1) {
+        LoadBaseRequests([input](json::SaxHandler& loader) {
+            json::Parse(input, loader);
+        }, catalogue, handler);
+        return;
+    }
+    
+    const string_view text = base_requests->value;
+    const size_t offset = text.data() - input.data();
+    string sections;
+    sections.reserve(input.size() - text.size() + 2);
+    sections.append(input.substr(0, offset)).append("[]"sv).append(input.substr(offset + text.size()));
+    BaseRequestsLoader loader([](requests::BaseRequest&) {});
+    json::Parse(sections, loader);
+    querys_ = json::Document(loader.ExtractSections());
+    
+    // Запросы разбираются частями в нескольких потоках, каждый в своё место общего массива
+    const vector<string_view>& items = base_requests->items;
+    vector<requests::BaseRequest> base(items.size());
+    parallel::ForEachChunk(items.size(), [&items, &base](size_t begin, size_t end) {
+        requests::BaseRequestDecoder decoder;
+        for (size_t i = begin; i < end; ++i) {
+            json::Parse(items[i], decoder);
+            base[i] = decoder.Extract();
         }
+    }, MIN_REQUESTS_CHUNK);
+    
+    // Остановки добавляются по порядку запросов, поэтому их номера не зависят от числа потоков
+    PendingRequests pending;
+    for (auto& request : base) {
+        pending.Add(request, catalogue);
     }
+    base = {};
+    AddPendingRequests(pending, catalogue, handler);
+}
+
+void JsonReader::LoadBaseRequests(const function<void(json::SaxHandler&)>& parse, 
+                                  TrC::TransportCatalogue& catalogue, const RequestHandler& handler) {
+    // Остановки добавляются сразу, расстояния и маршруты - после того, как известны все остановки
+    PendingRequests pending;
+    BaseRequestsLoader loader([&](requests::BaseRequest& request) {
+        pending.Add(request, catalogue);
+    });
+    parse(loader);
+    querys_ = json::Document(loader.ExtractSections());
+    AddPendingRequests(pending, catalogue, handler);
 }
 
 void MakeStopReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map) {
@@ -63,8 +357,12 @@ void MakeStopReport(const json::Dict& request, const RequestHandler& handler, js
         map["error_message"s] = "not found"s;
         return;
     }
-    const vector<string> temp = handler.GetBusesByStop(request.at("name"s).AsString());
-    json::Array arr(temp.begin(), temp.end());
+    const TrC::BusesRange buses = handler.GetBusesByStop(request.at("name"s).AsString());
+    json::Array arr;
+    arr.reserve(buses.size());
+    for (const string_view bus : buses) {
+        arr.emplace_back(string(bus));
+    }
     map["buses"s] = move(arr);
 }
 
@@ -80,7 +378,74 @@ void MakeBusReport(const json::Dict& request, const RequestHandler& handler, jso
     map["unique_stop_count"s] = info->unique_stops;
 }
 
-void MakeRouteReport(const json::Dict& request, router::TransportRouter& router, json::Dict& map) {
+void MakeNearestStopsReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map) {
+    const geo::Coordinates coord{request.at("latitude"s).AsDouble(), request.at("longitude"s).AsDouble()};
+    const int count = request.at("count"s).AsInt();
+    json::Array stops;
+    for (const auto& [stop, distance] : handler.GetNearestStops(coord, count > 0 ? count : 0)) {
+        stops.push_back(json::Builder{}.StartDict().Key("name"s).Value(stop->name).
+        Key("distance"s).Value(distance).EndDict().Build());
+    }
+    map["stops"s] = move(stops);
+}
+
+void MakeStopsInAreaReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map) {
+    const geo::Coordinates min{request.at("min_latitude"s).AsDouble(), request.at("min_longitude"s).AsDouble()};
+    const geo::Coordinates max{request.at("max_latitude"s).AsDouble(), request.at("max_longitude"s).AsDouble()};
+    json::Array stops;
+    for (const TrC::Stop* stop : handler.GetStopsInArea(min, max)) {
+        stops.emplace_back(stop->name);
+    }
+    map["stops"s] = move(stops);
+}
+
+void MakeSearchNamesReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map) {
+    const string& query = request.at("query"s).AsString();
+    const int limit = request.count("limit"s) ? request.at("limit"s).AsInt() : 10;
+    const bool fuzzy = request.count("mode"s) && request.at("mode"s).AsString() == "fuzzy"s;
+    const auto names = fuzzy ? handler.GetSimilarNames(query, limit > 0 ? limit : 0) 
+                             : handler.GetNamesByPrefix(query, limit > 0 ? limit : 0);
+    json::Array matches;
+    for (const auto& match : names) {
+        matches.push_back(json::Builder{}.StartDict().Key("name"s).Value(string(match.name)).
+        Key("type"s).Value(match.is_bus ? "Bus"s : "Stop"s).EndDict().Build());
+    }
+    map["matches"s] = move(matches);
+}
+
+void MakeBusPositionsReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map) {
+    auto make_position = [](string_view name, const vehicles::Position& position) {
+        // Время, не помещающееся в int, выводится как double
+        json::Node timestamp = position.timestamp >= numeric_limits<int>::min() 
+            && position.timestamp <= numeric_limits<int>::max() ? json::Node(static_cast<int>(position.timestamp)) 
+                                                                : json::Node(static_cast<double>(position.timestamp));
+        return json::Builder{}.StartDict().Key("name"s).Value(string(name)).
+        Key("latitude"s).Value(position.coord.lat).Key("longitude"s).Value(position.coord.lng).
+        Key("timestamp"s).Value(timestamp).EndDict().Build();
+    };
+    
+    json::Array buses;
+    if (request.count("name"s)) {
+        const string& name = request.at("name"s).AsString();
+        if (!handler.BusCount(name)) {
+            map["error_message"s] = "not found"s;
+            return;
+        }
+        if (const auto position = handler.GetBusPosition(name)) {
+            buses.push_back(make_position(name, *position));
+        }
+    }
+    else {
+        const geo::Coordinates min{request.at("min_latitude"s).AsDouble(), request.at("min_longitude"s).AsDouble()};
+        const geo::Coordinates max{request.at("max_latitude"s).AsDouble(), request.at("max_longitude"s).AsDouble()};
+        for (const auto& [name, position] : handler.GetBusPositionsInArea(min, max)) {
+            buses.push_back(make_position(name, position));
+        }
+    }
+    map["buses"s] = move(buses);
+}
+
+void MakeRouteReport(const json::Dict& request, const router::TransportRouter& router, json::Dict& map) {
     const auto& from = request.at("from"s).AsString();
     const auto& to = request.at("to"s).AsString();
 
@@ -110,32 +475,247 @@ void MakeRouteReport(const json::Dict& request, router::TransportRouter& router,
     map["items"s] = items;
 }
 
-json::Document JsonReader::MakeReport(const RequestHandler& handler, router::TransportRouter& router) const {
-    //router::TransportRouter router = handler.MakeTransportRouterWithGraph(ReadRoutingSettings());
-    json::Array data;
-    data.reserve(querys_.GetRoot().AsDict().at("stat_requests"s).AsArray().size());
-    for (const auto& value : querys_.GetRoot().AsDict().at("stat_requests"s).AsArray()) {
+json::Dict MakeRequestReport(const json::Dict& request, const RequestHandler& handler, 
+                             const router::TransportRouter& router) {
+    json::Dict map;
+    map["request_id"s] = request.at("id"s).AsInt();
+    switch (requests::GetStatType(request.at("type"s).AsString())) {
+        case requests::StatType::STOP:
+            MakeStopReport(request, handler, map);
+            break;
+        case requests::StatType::BUS:
+            MakeBusReport(request, handler, map);
+            break;
+        case requests::StatType::ROUTE:
+            MakeRouteReport(request, router, map);
+            break;
+        case requests::StatType::NEAREST_STOPS:
+            MakeNearestStopsReport(request, handler, map);
+            break;
+        case requests::StatType::STOPS_IN_AREA:
+            MakeStopsInAreaReport(request, handler, map);
+            break;
+        case requests::StatType::SEARCH_NAMES:
+            MakeSearchNamesReport(request, handler, map);
+            break;
+        case requests::StatType::BUS_POSITIONS:
+            MakeBusPositionsReport(request, handler, map);
+            break;
+        case requests::StatType::MAP:
+            map["map"s] = handler.GetMap();
+            break;
+    }
+    return map;
+}
+
+void JsonReader::WriteReport(ostream& output, const RequestHandler& handler, const router::TransportRouter& router,
+                             json::Format format) const {
+    const json::Array& requests = querys_.GetRoot().AsDict().at("stat_requests"s).AsArray();
+    json::Writer writer(output, format);
+    writer.StartArray();
+    parallel::ForEachOrdered(requests.size(), [&](size_t i) {
+        return MakeRequestReport(requests[i].AsDict(), handler, router);
+    }, [&writer](size_t, const json::Dict& report) {
+        writer.Value(report);
+    }, REPORTS_WINDOW_PER_THREAD * parallel::GetThreadCount());
+    writer.EndArray();
+}
+
+namespace {
+
+string CityOf(const json::Dict& request) {
+    const auto it = request.find("city"s);
+    return it == request.end() ? string() : it->second.AsString();
+}
+
+json::Dict MakeCityRequestReport(const json::Dict& request, CityRegistry& registry) {
+    shared_ptr<City> city;
+    try {
+        city = registry.Get(CityOf(request));
+    }
+    catch (const exception&) {
+        // Неизвестный город или город, базу которого не удалось загрузить
         json::Dict map;
-        map["request_id"s] = value.AsDict().at("id"s).AsInt();
-        if (value.AsDict().at("type"s).AsString() == "Stop"s) {
-            MakeStopReport(value.AsDict(), handler, map);
-        }
-        else if (value.AsDict().at("type"s).AsString() == "Bus"s) {
-            MakeBusReport(value.AsDict(), handler, map);
-        } 
-        else if (value.AsDict().at("type"s).AsString() == "Route"s) {
-            MakeRouteReport(value.AsDict(), router, map);
-            }
-        else {
-            svg::Document doc = handler.RenderMap();
-            ostringstream ost;
-            doc.Render(ost);
-            map["map"s] = ost.str();
+        map["request_id"s] = request.at("id"s).AsInt();
+        map["error_message"s] = "not found"s;
+        return map;
+    }
+    return MakeRequestReport(request, city->handler, city->router);
+}
+
+// Ответ на строку, которую не удалось разобрать или обработать; request_id - если он известен
+json::Dict MakeInvalidRequestReport(const json::Dict* request) {
+    json::Dict map;
+    if (request) {
+        if (const auto it = request->find("id"s); it != request->end() && it->second.IsInt()) {
+            map["request_id"s] = it->second.AsInt();
         }
-        data.emplace_back(map);
+    }
+    map["error_message"s] = "invalid request"s;
+    return map;
+}
+
+using Answer = function<json::Dict(const json::Dict&)>;
+
+json::Dict MakeLineReport(string_view line, const Answer& answer) {
+    try {
+        const json::Document document = json::Load(line);
+        const json::Dict& request = document.GetRoot().AsDict();
+        try {
+            return answer(request);
+        }
+        catch (const exception&) {
+            return MakeInvalidRequestReport(&request);
+        }
+    }
+    catch (const exception&) {
+        return MakeInvalidRequestReport(nullptr);
+    }
+}
+
+string ToLine(const json::Dict& report) {
+    ostringstream output;
+    {
+        json::Writer writer(output, json::Format::COMPACT);
+        writer.Value(report);
+    }
+    return output.str();
+}
+
+string MakeLineReportText(string_view line, const Answer& answer) {
+    return ToLine(MakeLineReport(line, answer));
+}
+
+void ServeLines(istream& input, ostream& output, const Answer& answer) {
+    string line;
+    while (getline(input, line)) {
+        if (line.find_first_not_of(" \t\r"s) == string::npos) {
+            continue;
+        }
+        // Каждый ответ - отдельный документ в одну строку, отправляемый сразу
+        json::Writer line_writer(output, json::Format::COMPACT);
+        line_writer.Value(MakeLineReport(line, answer));
+        line_writer.Flush();
+        output.put('\n');
+        output.flush();
+    }
+}
+
+} // namespace
+
+void JsonReader::WriteReport(ostream& output, CityRegistry& registry, json::Format format) const {
+    const json::Array& requests = querys_.GetRoot().AsDict().at("stat_requests"s).AsArray();
+    
+    // Пока обрабатываются запросы к одному городу, следующий за ним город загружается в фоне
+    vector<optional<string>> next_cities(requests.size());
+    for (size_t i = requests.size(); i-- > 1;) {
+        const string city = CityOf(requests[i].AsDict());
+        next_cities[i - 1] = city != CityOf(requests[i - 1].AsDict()) ? city : next_cities[i];
     }
     
-    return json::Document(json::Builder{}.Value(data).Build());
+    json::Writer writer(output, format);
+    writer.StartArray();
+    parallel::ForEachOrdered(requests.size(), [&](size_t i) {
+        if (next_cities[i] && (i == 0 || next_cities[i] != next_cities[i - 1])) {
+            registry.Prefetch(*next_cities[i]);
+        }
+        return MakeCityRequestReport(requests[i].AsDict(), registry);
+    }, [&writer](size_t, const json::Dict& report) {
+        writer.Value(report);
+    }, REPORTS_WINDOW_PER_THREAD * parallel::GetThreadCount());
+    writer.EndArray();
+}
+
+void ServeRequests(istream& input, ostream& output, const RequestHandler& handler, const router::TransportRouter& router) {
+    ServeLines(input, output, [&](const json::Dict& request) {
+        return MakeRequestReport(request, handler, router);
+    });
+}
+
+void ServeRequests(istream& input, ostream& output, CityRegistry& registry) {
+    ServeLines(input, output, [&](const json::Dict& request) {
+        return MakeCityRequestReport(request, registry);
+    });
+}
+
+string MakeLineReport(string_view line, const RequestHandler& handler, const router::TransportRouter& router) {
+    return MakeLineReportText(line, [&](const json::Dict& request) {
+        return MakeRequestReport(request, handler, router);
+    });
+}
+
+string MakeLineReport(string_view line, CityRegistry& registry) {
+    return MakeLineReportText(line, [&](const json::Dict& request) {
+        return MakeCityRequestReport(request, registry);
+    });
+}
+
+namespace {
+
+vector<string> ReadNames(const json::Dict& request, const string& key) {
+    vector<string> names;
+    if (const auto it = request.find(key); it != request.end()) {
+        for (const auto& name : it->second.AsArray()) {
+            names.push_back(name.AsString());
+        }
+    }
+    return names;
+}
+
+// Изменения справочника из запроса Update; base_requests - в формате запроса make_base
+TrC::CatalogueUpdate ReadCatalogueUpdate(const json::Dict& request) {
+    TrC::CatalogueUpdate update;
+    if (const auto it = request.find("base_requests"s); it != request.end()) {
+        for (const auto& node : it->second.AsArray()) {
+            const json::Dict& item = node.AsDict();
+            const string& type = item.at("type"s).AsString();
+            const string& name = item.at("name"s).AsString();
+            if (type == "Stop"sv) {
+                update.add_stops.push_back({name, {item.at("latitude"s).AsDouble(), item.at("longitude"s).AsDouble()}});
+                if (const auto distances = item.find("road_distances"s); distances != item.end()) {
+                    for (const auto& [to, distance] : distances->second.AsDict()) {
+                        update.distances.emplace_back(name, string(to), static_cast<unsigned>(distance.AsInt()));
+                    }
+                }
+            } else if (type == "Bus"sv) {
+                update.add_buses.push_back({name, ReadNames(item, "stops"s), item.at("is_roundtrip"s).AsBool()});
+            } else {
+                throw invalid_argument("Unknown base request type "s + type);
+            }
+        }
+    }
+    update.remove_stops = ReadNames(request, "remove_stops"s);
+    update.remove_buses = ReadNames(request, "remove_buses"s);
+    return update;
+}
+
+} // namespace
+
+void MakeLineReport(string_view line, LiveBase& base, const function<void(string)>& respond) {
+    optional<TrC::CatalogueUpdate> update;
+    int id = 0;
+    string report = MakeLineReportText(line, [&](const json::Dict& request) {
+        if (request.at("type"s).AsString() != "Update"sv) {
+            const LiveBase::ReadGuard city = base.Read();
+            return MakeRequestReport(request, city->handler, city->router);
+        }
+        id = request.at("id"s).AsInt();
+        update = ReadCatalogueUpdate(request);
+        return json::Dict{};
+    });
+    if (!update) {
+        respond(move(report));
+        return;
+    }
+    // Новую версию строит фоновый поток базы, ответ отправляется после её публикации
+    base.Update(move(*update), [id, respond](exception_ptr error) {
+        json::Dict map;
+        map["request_id"s] = id;
+        if (error) {
+            map["error_message"s] = "invalid request"s;
+        }
+        respond(ToLine(map));
+    });
 }
 
 renderer::RenderSettings JsonReader::ReadRenderSettings() const {
@@ -172,4 +752,29 @@ router::RoutingSettings JsonReader::ReadRoutingSettings() const {
 string JsonReader::ReadSerializationSettings() const {
     json::Dict map = querys_.GetRoot().AsDict().at("serialization_settings"s).AsDict();
     return map.at("file"s).AsString();
+}
+
+bool JsonReader::HasCities() const {
+    return querys_.GetRoot().AsDict().at("serialization_settings"s).AsDict().count("cities"s);
+}
+
+map<string, string, less<>> JsonReader::ReadCities() const {
+    const json::Dict& settings = querys_.GetRoot().AsDict().at("serialization_settings"s).AsDict();
+    map<string, string, less<>> cities;
+    for (const auto& [name, file] : settings.at("cities"s).AsDict()) {
+        cities[name] = file.AsString();
+    }
+    // Запросы без поля city обращаются к базе из поля file
+    if (settings.count("file"s)) {
+        cities[""s] = settings.at("file"s).AsString();
+    }
+    return cities;
+}
+
+size_t JsonReader::ReadMemoryBudget() const {
+    const json::Dict& settings = querys_.GetRoot().AsDict().at("serialization_settings"s).AsDict();
+    if (!settings.count("memory_budget"s)) {
+        return CityRegistry::UNLIMITED;
+    }
+    return static_cast<size_t>(settings.at("memory_budget"s).AsDouble());
 }
\ No newline at end of file
@@ -1,33 +1,57 @@
 #pragma once
 
 #include "transport_catalogue.h"
+#include "city_registry.h"
+#include "live_base.h"
 #include "request_handler.h"
 #include "json_builder.h"
+#include "json_sax.h"
+#include "json_writer.h"
+#include "request_decoder.h"
+
+#include <functional>
+#include <string_view>
 
 svg::Color ToColor(const json::Node& node);
 
 class JsonReader {
 public:
-    JsonReader() = default;
-    explicit JsonReader(const json::Document& querys) : querys_{ querys } {
+    JsonReader() : querys_{json::Node{}} {
+    }
+    explicit JsonReader(json::Document querys) : querys_{ std::move(querys) } {
     }
     explicit JsonReader(std::istream& ist) : querys_{ json::Load(ist) } {
     }
+    // Разбирает запросы из буфера в памяти, например из отображённого в память файла
+    explicit JsonReader(std::string_view input) : querys_{ json::Load(input) } {
+    }
     JsonReader(const JsonReader&) = delete;
     
     JsonReader& operator=(const JsonReader&) = delete;
     
-    void SetQuerys(const json::Document& querys) {
-        querys_ = querys;
+    void SetQuerys(json::Document querys) {
+        querys_ = std::move(querys);
     }
     
     const json::Document& GetQuerys() const {
         return querys_;
     }
     
-    void FillingCatalogue(TrC::TransportCatalogue& catalogue, const RequestHandler& handler) const;
+    // Потоково читает запрос make_base из input, не строя дерево всего документа: base_requests
+    // сразу добавляются в справочник, остальные разделы становятся документом querys_
+    void FillingCatalogue(std::istream& input, TrC::TransportCatalogue& catalogue, const RequestHandler& handler);
+    // Документ в памяти при нескольких потоках (parallel::GetThreadCount) сначала делится
+    // на элементы base_requests, которые затем разбираются частями параллельно
+    void FillingCatalogue(std::string_view input, TrC::TransportCatalogue& catalogue, const RequestHandler& handler);
+    
+    // Пишет ответы на stat_requests в output по мере их вычисления. Запросы обрабатываются
+    // параллельно (parallel::GetThreadCount), но ответы выводятся в исходном порядке, а в памяти
+    // хранятся только ответы, вычисленные с опережением на несколько запросов
+    void WriteReport(std::ostream& output, const RequestHandler& handler, const router::TransportRouter& router,
+                     json::Format format = json::Format::PRETTY) const;
     
-    json::Document MakeReport(const RequestHandler& handler, router::TransportRouter& router) const;
+    // Обрабатывает запросы к нескольким городам, выбирая справочник по полю city запроса
+    void WriteReport(std::ostream& output, CityRegistry& registry, json::Format format = json::Format::PRETTY) const;
     
     renderer::RenderSettings ReadRenderSettings() const;
     
@@ -35,17 +59,58 @@ public:
     
     std::string ReadSerializationSettings() const;
     
+    // Заданы ли в serialization_settings базы нескольких городов (поле cities)
+    bool HasCities() const;
+    
+    // Пути к базам городов по их названиям; база из поля file доступна под пустым названием
+    std::map<std::string, std::string, std::less<>> ReadCities() const;
+    
+    // Бюджет памяти загруженных городов в байтах (поле memory_budget)
+    size_t ReadMemoryBudget() const;
+    
 private:
-    TrC::Stop MakeStop(const json::Dict& stop) const;
-    TrC::Bus MakeBus(const RequestHandler& handler, const json::Dict& bus) const;
-    std::pair<TrC::Stop*,std::vector<TrC::detail::DistanceToStop>> 
-        MakeDistances(const RequestHandler& handler, const json::Dict& stop) const;
+    void LoadBaseRequests(const std::function<void(json::SaxHandler&)>& parse, 
+                          TrC::TransportCatalogue& catalogue, const RequestHandler& handler);
     
     json::Document querys_;
 };
 
+json::Dict MakeRequestReport(const json::Dict& request, const RequestHandler& handler, 
+                             const router::TransportRouter& router);
+
+// Построчный режим (NDJSON): каждая непустая строка input - один запрос из stat_requests, ответ
+// на него пишется в output одной строкой и сразу отправляется. На строку, которую не удалось
+// разобрать или обработать, отвечает {"error_message": "invalid request"} и продолжает работу
+void ServeRequests(std::istream& input, std::ostream& output, const RequestHandler& handler, 
+                   const router::TransportRouter& router);
+
+// То же для нескольких городов: справочник выбирается по полю city запроса
+void ServeRequests(std::istream& input, std::ostream& output, CityRegistry& registry);
+
+// Ответ на одну строку построчного режима - JSON в одну строку, без перевода строки.
+// Не бросает исключений на некорректные запросы и может вызываться из нескольких потоков
+std::string MakeLineReport(std::string_view line, const RequestHandler& handler,
+                           const router::TransportRouter& router);
+std::string MakeLineReport(std::string_view line, CityRegistry& registry);
+
+// То же для изменяемой базы. Кроме stat_requests принимает запрос изменения справочника
+// {"id": 1, "type": "Update", "base_requests": [...], "remove_stops": [...], "remove_buses": [...]}:
+// остановки и маршруты base_requests в формате make_base добавляются или заменяют прежние, а
+// перечисленные удаляются. Ответ передаётся respond: на Update - {"request_id": 1} после
+// публикации новой версии, которую строит фоновый поток base, поэтому функция возвращает
+// управление, не дожидаясь его; на остальные запросы - до возврата
+void MakeLineReport(std::string_view line, LiveBase& base, const std::function<void(std::string)>& respond);
+
 void MakeStopReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map);
 
 void MakeBusReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map);
 
-void MakeRouteReport(const json::Dict& request, router::TransportRouter& router, json::Dict& map);
\ No newline at end of file
+void MakeNearestStopsReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map);
+
+void MakeStopsInAreaReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map);
+
+void MakeSearchNamesReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map);
+
+void MakeBusPositionsReport(const json::Dict& request, const RequestHandler& handler, json::Dict& map);
+
+void MakeRouteReport(const json::Dict& request, const router::TransportRouter& router, json::Dict& map);
\ No newline at end of file
@@ -0,0 +1,655 @@
+#include "json_sax.h"
+
+#include <cctype>
+#include <charconv>
+#include <iterator>
+#include <stdexcept>
+#include <streambuf>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace json {
+
+namespace {
+using namespace std::literals;
+
+bool IsWhitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool IsStringSpecial(char c) {
+    return c == '"' || c == '\\' || c == '\n' || c == '\r';
+}
+
+// Поиск в буфере блоками по 32 (AVX2) или 16 (SSE2) байт: сравнения дают маску байтов блока,
+// номер первого нужного байта - число младших нулевых битов маски. Хвост короче блока
+// и сборки без SSE2 обрабатываются побайтно
+
+// Первый символ, завершающий простой отрезок строки: кавычка, \ или перевод строки
+const char* FindStringSpecial(const char* pos, const char* end) {
+#if defined(__AVX2__)
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    for (; end - pos >= 32; pos += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, lf), _mm256_cmpeq_epi8(block, cr)));
+        if (const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits))) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i quote16 = _mm_set1_epi8('"');
+    const __m128i backslash16 = _mm_set1_epi8('\\');
+    const __m128i lf16 = _mm_set1_epi8('\n');
+    const __m128i cr16 = _mm_set1_epi8('\r');
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, quote16), _mm_cmpeq_epi8(block, backslash16)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, lf16), _mm_cmpeq_epi8(block, cr16)));
+        if (const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits))) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (pos != end && !IsStringSpecial(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+// Первый непробельный символ. Между лексемами обычно не больше пары пробелов, поэтому
+// блочный поиск начинается только после них
+const char* SkipWhitespace(const char* pos, const char* end) {
+    for (int i = 0; i < 2; ++i, ++pos) {
+        if (pos == end || !IsWhitespace(*pos)) {
+            return pos;
+        }
+    }
+#if defined(__AVX2__)
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    for (; end - pos >= 32; pos += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i spaces = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, lf)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, cr), _mm256_cmpeq_epi8(block, tab)));
+        if (const unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(spaces))) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i space16 = _mm_set1_epi8(' ');
+    const __m128i lf16 = _mm_set1_epi8('\n');
+    const __m128i cr16 = _mm_set1_epi8('\r');
+    const __m128i tab16 = _mm_set1_epi8('\t');
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i spaces = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, space16), _mm_cmpeq_epi8(block, lf16)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, cr16), _mm_cmpeq_epi8(block, tab16)));
+        if (const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(spaces)) & 0xFFFFu) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (pos != end && IsWhitespace(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+// Первая кавычка или скобка. Коды [ и ] отличаются от { и } одним битом 0x20, поэтому
+// после его установки все четыре скобки находятся двумя сравнениями
+const char* FindStructural(const char* pos, const char* end) {
+#if defined(__AVX2__)
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i case_bit = _mm256_set1_epi8(0x20);
+    const __m256i open = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    for (; end - pos >= 32; pos += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i folded = _mm256_or_si256(block, case_bit);
+        const __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(block, quote),
+            _mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)));
+        if (const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits))) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i quote16 = _mm_set1_epi8('"');
+    const __m128i case_bit16 = _mm_set1_epi8(0x20);
+    const __m128i open16 = _mm_set1_epi8('{');
+    const __m128i close16 = _mm_set1_epi8('}');
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i folded = _mm_or_si128(block, case_bit16);
+        const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, quote16),
+            _mm_or_si128(_mm_cmpeq_epi8(folded, open16), _mm_cmpeq_epi8(folded, close16)));
+        if (const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits))) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (pos != end && *pos != '"' && (*pos | 0x20) != '{' && (*pos | 0x20) != '}') {
+        ++pos;
+    }
+    return pos;
+}
+
+// Позиция за строкой, открывающая кавычка которой находится в pos
+const char* SkipString(const char* pos, const char* end) {
+    for (++pos;;) {
+        pos = FindStringSpecial(pos, end);
+        if (pos == end) {
+            throw ParsingError("String parsing error"s);
+        }
+        if (*pos == '"') {
+            return pos + 1;
+        }
+        if (*pos == '\\' && ++pos == end) {
+            throw ParsingError("String parsing error"s);
+        }
+        ++pos;
+    }
+}
+
+// Позиция за значением, начинающимся в pos. Внутри массивов и словарей считаются только
+// скобки и строки, остальное содержимое не проверяется
+const char* SkipValue(const char* pos, const char* end) {
+    if (pos == end) {
+        throw ParsingError("Unexpected EOF"s);
+    }
+    if (*pos == '"') {
+        return SkipString(pos, end);
+    }
+    if (*pos != '[' && *pos != '{') {
+        // Число или литерал продолжается до разделителя
+        while (pos != end && *pos != ',' && *pos != ']' && *pos != '}' && !IsWhitespace(*pos)) {
+            ++pos;
+        }
+        return pos;
+    }
+    for (size_t depth = 0;;) {
+        pos = FindStructural(pos, end);
+        if (pos == end) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        if (*pos == '"') {
+            pos = SkipString(pos, end);
+            continue;
+        }
+        if (*pos == '[' || *pos == '{') {
+            ++depth;
+        } else if (--depth == 0) {
+            return pos + 1;
+        }
+        ++pos;
+    }
+}
+
+// Пропускает пробелы и запятые между элементами. Как и при разборе, запятые необязательны
+const char* SkipSeparators(const char* pos, const char* end) {
+    for (pos = SkipWhitespace(pos, end); pos != end && *pos == ','; pos = SkipWhitespace(pos + 1, end)) {
+    }
+    return pos;
+}
+
+// Делит массив, начинающийся в pos, на тексты элементов. Возвращает позицию за массивом
+const char* SplitItems(const char* pos, const char* end, std::vector<std::string_view>& items) {
+    for (pos = SkipSeparators(pos + 1, end); pos == end || *pos != ']'; pos = SkipSeparators(pos, end)) {
+        if (pos == end) {
+            throw ParsingError("Array parsing error"s);
+        }
+        const char* item = pos;
+        pos = SkipValue(item, end);
+        items.emplace_back(item, pos - item);
+    }
+    return pos + 1;
+}
+
+// Источник символов, читающий напрямую из буфера потока
+class StreamSource {
+public:
+    static constexpr int END = std::char_traits<char>::eof();
+    static constexpr bool CONTIGUOUS = false;
+
+    explicit StreamSource(std::istream& input) : buffer_(*input.rdbuf()) {
+    }
+
+    int Peek() {
+        return buffer_.sgetc();
+    }
+
+    int Get() {
+        return buffer_.sbumpc();
+    }
+
+private:
+    std::streambuf& buffer_;
+};
+
+// Источник символов из непрерывного буфера в памяти. Строки без escape-последовательностей
+// передаются обработчику как string_view прямо в буфер, без копирования
+class BufferSource {
+public:
+    static constexpr int END = std::char_traits<char>::eof();
+    static constexpr bool CONTIGUOUS = true;
+
+    explicit BufferSource(std::string_view input) : pos_(input.data()), end_(input.data() + input.size()) {
+    }
+
+    int Peek() const {
+        return pos_ != end_ ? static_cast<unsigned char>(*pos_) : END;
+    }
+
+    int Get() {
+        return pos_ != end_ ? static_cast<unsigned char>(*pos_++) : END;
+    }
+
+    const char* Position() const {
+        return pos_;
+    }
+
+    const char* End() const {
+        return end_;
+    }
+
+    void SetPosition(const char* pos) {
+        pos_ = pos;
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+};
+
+template <typename Source>
+class SaxParser {
+public:
+    SaxParser(Source& source, SaxHandler& handler) : source_(source), handler_(handler) {
+    }
+
+    void ParseDocument() {
+        ParseValue(NextToken());
+    }
+
+private:
+    // Пропускает пробельные символы и возвращает следующий символ
+    int NextToken() {
+        if constexpr (Source::CONTIGUOUS) {
+            source_.SetPosition(SkipWhitespace(source_.Position(), source_.End()));
+        }
+        int c = source_.Get();
+        while (c != Source::END && std::isspace(c)) {
+            c = source_.Get();
+        }
+        return c;
+    }
+
+    void ParseValue(int c) {
+        switch (c) {
+            case Source::END:
+                throw ParsingError("Unexpected EOF"s);
+            case '[':
+                ParseArray();
+                break;
+            case '{':
+                ParseDict();
+                break;
+            case '"':
+                handler_.Value(ParseString());
+                break;
+            case 't':
+            case 'f':
+                ParseBool(c);
+                break;
+            case 'n':
+                ParseNull();
+                break;
+            default:
+                ParseNumber(c);
+        }
+    }
+
+    void ParseArray() {
+        handler_.StartArray();
+        for (int c = NextToken(); c != ']'; c = NextToken()) {
+            if (c == Source::END) {
+                throw ParsingError("Array parsing error"s);
+            }
+            if (c != ',') {
+                ParseValue(c);
+            }
+        }
+        handler_.EndArray();
+    }
+
+    void ParseDict() {
+        handler_.StartDict();
+        for (int c = NextToken(); c != '}'; c = NextToken()) {
+            if (c == '"') {
+                handler_.Key(ParseString());
+                if (const int colon = NextToken(); colon != ':') {
+                    throw ParsingError(": is expected but '"s + static_cast<char>(colon) + "' has been found"s);
+                }
+                ParseValue(NextToken());
+            } else if (c == Source::END) {
+                throw ParsingError("Dictionary parsing error"s);
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + static_cast<char>(c) + "' has been found"s);
+            }
+        }
+        handler_.EndDict();
+    }
+
+    // Возвращает строку, действительную до следующего вызова: она лежит во входном буфере
+    // или, если содержит escape-последовательности, во внутреннем буфере разборщика
+    std::string_view ParseString() {
+        buffer_.clear();
+        if constexpr (Source::CONTIGUOUS) {
+            const char* begin = source_.Position();
+            const char* end = source_.End();
+            const char* pos = FindStringSpecial(begin, end);
+            if (pos != end && *pos == '"') {
+                source_.SetPosition(pos + 1);
+                return std::string_view(begin, pos - begin);
+            }
+            // Строка с escape-последовательностями или ошибкой разбирается посимвольно
+            buffer_.assign(begin, pos);
+            source_.SetPosition(pos);
+        }
+        while (true) {
+            const int ch = source_.Get();
+            if (ch == Source::END) {
+                throw ParsingError("String parsing error");
+            }
+            if (ch == '"') {
+                break;
+            }
+            if (ch == '\\') {
+                const int escaped_char = source_.Get();
+                switch (escaped_char) {
+                    case 'n':
+                        buffer_.push_back('\n');
+                        break;
+                    case 't':
+                        buffer_.push_back('\t');
+                        break;
+                    case 'r':
+                        buffer_.push_back('\r');
+                        break;
+                    case '"':
+                        buffer_.push_back('"');
+                        break;
+                    case '\\':
+                        buffer_.push_back('\\');
+                        break;
+                    case Source::END:
+                        throw ParsingError("String parsing error");
+                    default:
+                        throw ParsingError("Unrecognized escape sequence \\"s + static_cast<char>(escaped_char));
+                }
+            } else if (ch == '\n' || ch == '\r') {
+                throw ParsingError("Unexpected end of line"s);
+            } else {
+                buffer_.push_back(static_cast<char>(ch));
+            }
+        }
+        return buffer_;
+    }
+
+    const std::string& ParseLiteral(int first) {
+        buffer_.assign(1, static_cast<char>(first));
+        while (std::isalpha(source_.Peek())) {
+            buffer_.push_back(static_cast<char>(source_.Get()));
+        }
+        return buffer_;
+    }
+
+    void ParseBool(int first) {
+        const std::string& literal = ParseLiteral(first);
+        if (literal == "true"sv) {
+            handler_.Value(true);
+        } else if (literal == "false"sv) {
+            handler_.Value(false);
+        } else {
+            throw ParsingError("Failed to parse '"s + literal + "' as bool"s);
+        }
+    }
+
+    void ParseNull() {
+        const std::string& literal = ParseLiteral('n');
+        if (literal != "null"sv) {
+            throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+        }
+        handler_.Value(nullptr);
+    }
+
+    // Число разбирается без выделения памяти: из входного буфера напрямую или, при чтении
+    // из потока, из внутреннего буфера разборщика
+    void ParseNumber(int first) {
+        const char* begin = nullptr;
+        if constexpr (Source::CONTIGUOUS) {
+            begin = source_.Position() - 1;
+        } else {
+            buffer_.assign(1, static_cast<char>(first));
+        }
+        auto take = [this] {
+            const int c = source_.Get();
+            if constexpr (!Source::CONTIGUOUS) {
+                buffer_.push_back(static_cast<char>(c));
+            }
+        };
+        auto read_digits = [this, &take] {
+            if (!std::isdigit(source_.Peek())) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (std::isdigit(source_.Peek())) {
+                take();
+            }
+        };
+
+        if (first == '-') {
+            if (source_.Peek() == '0') {
+                take();
+            } else {
+                read_digits();
+            }
+        } else if (!std::isdigit(first)) {
+            throw ParsingError("A digit is expected"s);
+        } else if (first != '0') {
+            // После 0 в JSON не могут идти другие цифры
+            while (std::isdigit(source_.Peek())) {
+                take();
+            }
+        }
+
+        bool is_int = true;
+        if (source_.Peek() == '.') {
+            take();
+            read_digits();
+            is_int = false;
+        }
+        if (const int ch = source_.Peek(); ch == 'e' || ch == 'E') {
+            take();
+            if (const int sign = source_.Peek(); sign == '+' || sign == '-') {
+                take();
+            }
+            read_digits();
+            is_int = false;
+        }
+
+        const char* end = nullptr;
+        if constexpr (Source::CONTIGUOUS) {
+            end = source_.Position();
+        } else {
+            begin = buffer_.data();
+            end = begin + buffer_.size();
+        }
+
+        if (is_int) {
+            int value;
+            // Не помещающееся в int целое читается как double
+            if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc()) {
+                handler_.Value(value);
+                return;
+            }
+        }
+        double value;
+        if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec != std::errc() || ptr != end) {
+            throw ParsingError("Failed to convert "s + std::string(begin, end) + " to number"s);
+        }
+        handler_.Value(value);
+    }
+
+    Source& source_;
+    SaxHandler& handler_;
+    std::string buffer_;
+};
+
+}  // namespace
+
+void Parse(std::istream& input, SaxHandler& handler) {
+    StreamSource source(input);
+    SaxParser<StreamSource>(source, handler).ParseDocument();
+}
+
+void Parse(std::string_view input, SaxHandler& handler) {
+    BufferSource source(input);
+    SaxParser<BufferSource>(source, handler).ParseDocument();
+}
+
+std::vector<Member> SplitDict(std::string_view text) {
+    const char* const end = text.data() + text.size();
+    const char* pos = SkipWhitespace(text.data(), end);
+    if (pos == end || *pos != '{') {
+        throw ParsingError("Dictionary parsing error"s);
+    }
+    std::vector<Member> members;
+    for (pos = SkipSeparators(pos + 1, end); pos == end || *pos != '}'; pos = SkipSeparators(pos, end)) {
+        if (pos == end) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        if (*pos != '"') {
+            throw ParsingError(R"(',' is expected but ')"s + *pos + "' has been found"s);
+        }
+        const char* key_end = SkipString(pos, end);
+        const std::string_view key(pos + 1, key_end - pos - 2);
+        pos = SkipWhitespace(key_end, end);
+        if (pos == end || *pos != ':') {
+            throw ParsingError(": is expected but '"s + (pos == end ? ""s : std::string(1, *pos)) + "' has been found"s);
+        }
+        Member& member = members.emplace_back();
+        // Ключ с escape-последовательностями декодируется полным разбором строки
+        member.key = key.find('\\') == key.npos ? std::string(key)
+                                                 : Load(std::string_view(key.data() - 1, key.size() + 2)).GetRoot().AsString();
+        const char* value = SkipWhitespace(pos + 1, end);
+        pos = value != end && *value == '[' ? SplitItems(value, end, member.items) : SkipValue(value, end);
+        member.value = std::string_view(value, pos - value);
+    }
+    return members;
+}
+
+void NodeBuilder::StartDict() {
+    stack_.push_back(Frame{true, entries_.size()});
+}
+
+void NodeBuilder::EndDict() {
+    if (stack_.empty() || !stack_.back().is_dict) {
+        throw std::logic_error("EndDict without StartDict"s);
+    }
+    const auto first = entries_.begin() + stack_.back().begin;
+    Dict dict(resource_);
+    dict.reserve(entries_.end() - first);
+    for (auto it = first; it != entries_.end(); ++it) {
+        if (const auto [pos, inserted] = dict.try_emplace(std::move(it->first), std::move(it->second)); !inserted) {
+            throw ParsingError("Duplicate key '"s + pos->first + "' have been found");
+        }
+    }
+    entries_.erase(first, entries_.end());
+    stack_.pop_back();
+    AddNode(std::move(dict));
+}
+
+void NodeBuilder::StartArray() {
+    stack_.push_back(Frame{false, items_.size()});
+}
+
+void NodeBuilder::EndArray() {
+    if (stack_.empty() || stack_.back().is_dict) {
+        throw std::logic_error("EndArray without StartArray"s);
+    }
+    const auto first = items_.begin() + stack_.back().begin;
+    Array array(resource_);
+    array.reserve(items_.end() - first);
+    std::move(first, items_.end(), std::back_inserter(array));
+    items_.erase(first, items_.end());
+    stack_.pop_back();
+    AddNode(std::move(array));
+}
+
+void NodeBuilder::Key(std::string_view key) {
+    if (stack_.empty() || !stack_.back().is_dict) {
+        throw std::logic_error("Key outside of a dictionary"s);
+    }
+    // Значение займёт место заготовки, когда будет разобрано
+    entries_.emplace_back(std::string(key), Node());
+}
+
+void NodeBuilder::Value(std::nullptr_t value) {
+    AddNode(Node(value));
+}
+
+void NodeBuilder::Value(bool value) {
+    AddNode(Node(value));
+}
+
+void NodeBuilder::Value(int value) {
+    AddNode(Node(value));
+}
+
+void NodeBuilder::Value(double value) {
+    AddNode(Node(value));
+}
+
+void NodeBuilder::Value(std::string_view value) {
+    AddNode(Node(std::string(value)));
+}
+
+void NodeBuilder::AddNode(Node node) {
+    if (stack_.empty()) {
+        if (has_root_) {
+            throw std::logic_error("Document already has a root"s);
+        }
+        root_ = std::move(node);
+        has_root_ = true;
+        return;
+    }
+    if (stack_.back().is_dict) {
+        entries_.back().second = std::move(node);
+    } else {
+        items_.push_back(std::move(node));
+    }
+}
+
+Node NodeBuilder::Build() {
+    if (!has_root_ || !stack_.empty()) {
+        throw std::logic_error("Document is not complete"s);
+    }
+    has_root_ = false;
+    return std::move(root_);
+}
+
+}  // namespace json
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "json.h"
+
+namespace json {
+
+// Обработчик событий потокового разбора JSON. События называются так же, как методы
+// json::Builder: разобранный документ можно воспроизвести, вызывая их по порядку
+class SaxHandler {
+public:
+    virtual ~SaxHandler() = default;
+
+    virtual void StartDict() = 0;
+    virtual void EndDict() = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    // Строки ключей и значений действительны только во время вызова
+    virtual void Key(std::string_view key) = 0;
+
+    virtual void Value(std::nullptr_t value) = 0;
+    virtual void Value(bool value) = 0;
+    virtual void Value(int value) = 0;
+    virtual void Value(double value) = 0;
+    virtual void Value(std::string_view value) = 0;
+};
+
+// Разбирает документ из input, не строя дерево Node, и сообщает handler о каждом элементе.
+// Принимает те же документы, что и json::Load, при ошибке бросает ParsingError
+void Parse(std::istream& input, SaxHandler& handler);
+
+// Разбирает документ из буфера в памяти, например из отображённого в память файла
+void Parse(std::string_view input, SaxHandler& handler);
+
+// Член словаря, найденный SplitDict
+struct Member {
+    std::string key;
+    std::string_view value;
+    // Тексты элементов значения, если оно - массив
+    std::vector<std::string_view> items;
+};
+
+// Делит словарь в начале text на члены, не разбирая значения: проверяются только разделители
+// и парность скобок и кавычек, разделители допускаются те же, что и при разборе. Элементы
+// массивов-значений находятся за тот же проход. Найденные тексты затем можно разбирать
+// независимо друг от друга, например в разных потоках
+std::vector<Member> SplitDict(std::string_view text);
+
+// Собирает дерево Node из событий разбора. Элементы незакрытых массивов и словарей
+// копятся в общих стеках; закрытый контейнер переносится в resource одним буфером точного размера
+class NodeBuilder final : public SaxHandler {
+public:
+    explicit NodeBuilder(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource_(resource) {
+    }
+
+    void StartDict() override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Key(std::string_view key) override;
+
+    void Value(std::nullptr_t value) override;
+    void Value(bool value) override;
+    void Value(int value) override;
+    void Value(double value) override;
+    void Value(std::string_view value) override;
+
+    // Возвращает собранный узел; бросает std::logic_error, если документ не завершён
+    Node Build();
+
+private:
+    struct Frame {
+        bool is_dict = false;
+        // Начало элементов контейнера в стеке items_ или entries_
+        size_t begin = 0;
+    };
+
+    void AddNode(Node node);
+
+    std::pmr::memory_resource* resource_;
+    std::vector<Frame> stack_;
+    std::vector<Node> items_;
+    std::vector<Dict::value_type> entries_;
+    Node root_;
+    bool has_root_ = false;
+};
+
+}  // namespace json
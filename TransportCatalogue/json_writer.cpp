@@ -0,0 +1,220 @@
+#include "json_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+
+namespace json {
+
+namespace {
+using namespace std::literals;
+
+const size_t INDENT_STEP = 4;
+
+// Специальные символы строки; остальные символы копируются в буфер целыми отрезками
+bool IsSpecial(char c) {
+    return c == '"' || c == '\\' || c == '\n' || c == '\r';
+}
+
+}  // namespace
+
+Writer::Writer(std::ostream& output, Format format) : out_(output), format_(format) {
+    buffer_.reserve(BUFFER_SIZE);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+void Writer::Flush() {
+    out_.write(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+void Writer::Write(std::string_view text) {
+    if (buffer_.size() + text.size() > BUFFER_SIZE) {
+        Flush();
+        // Длинный текст уходит в поток, минуя буфер
+        if (text.size() >= BUFFER_SIZE) {
+            out_.write(text.data(), text.size());
+            return;
+        }
+    }
+    buffer_.append(text);
+}
+
+void Writer::StartDict() {
+    StartValue();
+    Write(format_ == Format::PRETTY ? "{\n"sv : "{"sv);
+    stack_.push_back(Frame{true});
+}
+
+void Writer::EndDict() {
+    if (stack_.empty() || !stack_.back().is_dict || after_key_) {
+        throw std::logic_error("EndDict without StartDict"s);
+    }
+    stack_.pop_back();
+    if (format_ == Format::PRETTY) {
+        Put('\n');
+        PrintIndent();
+    }
+    Put('}');
+}
+
+void Writer::StartArray() {
+    StartValue();
+    Write(format_ == Format::PRETTY ? "[\n"sv : "["sv);
+    stack_.push_back(Frame{false});
+}
+
+void Writer::EndArray() {
+    if (stack_.empty() || stack_.back().is_dict) {
+        throw std::logic_error("EndArray without StartArray"s);
+    }
+    stack_.pop_back();
+    if (format_ == Format::PRETTY) {
+        Put('\n');
+        PrintIndent();
+    }
+    Put(']');
+}
+
+void Writer::Key(std::string_view key) {
+    if (stack_.empty() || !stack_.back().is_dict || after_key_) {
+        throw std::logic_error("Key outside of a dictionary"s);
+    }
+    StartItem();
+    PrintString(key);
+    Write(format_ == Format::PRETTY ? ": "sv : ":"sv);
+    after_key_ = true;
+}
+
+void Writer::Value(std::nullptr_t) {
+    StartValue();
+    Write("null"sv);
+}
+
+void Writer::Value(bool value) {
+    StartValue();
+    Write(value ? "true"sv : "false"sv);
+}
+
+// Числа выводятся через std::to_chars без выделения памяти. Для double это кратчайшая запись,
+// по которой читается в точности то же значение
+void Writer::Value(int value) {
+    StartValue();
+    char buffer[16];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    Write(std::string_view(buffer, result.ptr - buffer));
+}
+
+void Writer::Value(double value) {
+    StartValue();
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    Write(std::string_view(buffer, result.ptr - buffer));
+}
+
+void Writer::Value(std::string_view value) {
+    StartValue();
+    PrintString(value);
+}
+
+void Writer::Value(const Node& node) {
+    if (node.IsArray()) {
+        StartArray();
+        for (const Node& item : node.AsArray()) {
+            Value(item);
+        }
+        EndArray();
+    } else if (node.IsDict()) {
+        StartDict();
+        for (const auto& [key, value] : node.AsDict()) {
+            Key(key);
+            Value(value);
+        }
+        EndDict();
+    } else if (node.IsString()) {
+        Value(std::string_view(node.AsString()));
+    } else {
+        std::visit([this](const auto& value) {
+            using Type = std::decay_t<decltype(value)>;
+            if constexpr (!std::is_same_v<Type, Array> && !std::is_same_v<Type, Dict>
+                          && !std::is_same_v<Type, std::string>) {
+                Value(value);
+            }
+        }, node.GetValue());
+    }
+}
+
+void Writer::StartItem() {
+    Frame& frame = stack_.back();
+    if (format_ == Format::COMPACT) {
+        if (!frame.is_empty) {
+            Put(',');
+        }
+    } else {
+        if (!frame.is_empty) {
+            Write(",\n"sv);
+        }
+        PrintIndent();
+    }
+    frame.is_empty = false;
+}
+
+void Writer::StartValue() {
+    if (after_key_) {
+        after_key_ = false;
+    } else if (!stack_.empty()) {
+        if (stack_.back().is_dict) {
+            throw std::logic_error("Value without Key"s);
+        }
+        StartItem();
+    } else if (has_root_) {
+        throw std::logic_error("Document already has a root"s);
+    } else {
+        has_root_ = true;
+    }
+}
+
+void Writer::PrintIndent() {
+    static const std::string spaces(64, ' ');
+    for (size_t left = stack_.size() * INDENT_STEP; left > 0;) {
+        const size_t count = std::min(left, spaces.size());
+        Write(std::string_view(spaces.data(), count));
+        left -= count;
+    }
+}
+
+void Writer::PrintString(std::string_view value) {
+    Put('"');
+    for (size_t pos = 0; pos < value.size();) {
+        size_t end = pos;
+        while (end < value.size() && !IsSpecial(value[end])) {
+            ++end;
+        }
+        Write(value.substr(pos, end - pos));
+        if (end == value.size()) {
+            break;
+        }
+        switch (value[end]) {
+            case '\r':
+                Write("\\r"sv);
+                break;
+            case '\n':
+                Write("\\n"sv);
+                break;
+            default:
+                // Символы " и \ выводятся как \" или \\, соответственно
+                Put('\\');
+                Put(value[end]);
+                break;
+        }
+        pos = end + 1;
+    }
+    Put('"');
+}
+
+}  // namespace json
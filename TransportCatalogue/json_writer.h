@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.h"
+#include "json_sax.h"
+
+namespace json {
+
+// Пишет JSON в поток по мере поступления событий, не строя дерево Node. События те же,
+// что у json::Builder и SaxHandler; вывод совпадает с json::Print для того же документа.
+// Текст копится в собственном буфере и уходит в поток крупными блоками при его заполнении,
+// при вызове Flush и при уничтожении объекта
+class Writer final : public SaxHandler {
+public:
+    explicit Writer(std::ostream& output, Format format = Format::PRETTY);
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    ~Writer();
+
+    void StartDict() override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Key(std::string_view key) override;
+
+    void Value(std::nullptr_t value) override;
+    void Value(bool value) override;
+    void Value(int value) override;
+    void Value(double value) override;
+    void Value(std::string_view value) override;
+    void Value(const std::string& value) {
+        Value(std::string_view(value));
+    }
+    // Без этой перегрузки строковый литерал был бы выведен как bool
+    void Value(const char* value) {
+        Value(std::string_view(value));
+    }
+    // Пишет готовый узел со всеми вложенными элементами
+    void Value(const Node& node);
+
+    // Записан ли документ целиком
+    bool IsComplete() const {
+        return has_root_ && stack_.empty();
+    }
+
+    // Передаёт накопленный текст в поток
+    void Flush();
+
+private:
+    struct Frame {
+        bool is_dict = false;
+        bool is_empty = true;
+    };
+
+    // Перевод строки и отступ перед очередным элементом открытого контейнера
+    void StartItem();
+    // Начало значения: элемента массива, значения после ключа или корня документа
+    void StartValue();
+    void PrintIndent();
+    void PrintString(std::string_view value);
+
+    void Put(char c) {
+        buffer_.push_back(c);
+        if (buffer_.size() >= BUFFER_SIZE) {
+            Flush();
+        }
+    }
+    void Write(std::string_view text);
+
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    std::ostream& out_;
+    Format format_;
+    std::string buffer_;
+    std::vector<Frame> stack_;
+    bool after_key_ = false;
+    bool has_root_ = false;
+};
+
+}  // namespace json
@@ -0,0 +1,120 @@
+#include "live_base.h"
+
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <signal.h>
+
+using namespace std;
+
+namespace {
+
+// Как часто проверяется, читают ли ещё заменённые версии
+const auto RECLAIM_INTERVAL = chrono::milliseconds(10);
+
+unique_ptr<const City> LoadBase(const string& path) {
+    auto city = make_unique<City>();
+    if (!city->Load(path)) {
+        throw runtime_error("Failed to load base "s + path);
+    }
+    return city;
+}
+
+} // namespace
+
+LiveBase::LiveBase(string path) : path_(move(path)), snapshots_(LoadBase(path_)) {
+    // Фоновый поток не принимает сигналы: их обрабатывает тот, кто их ждёт, например сервер
+    sigset_t all;
+    sigset_t previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    thread_ = thread([this] { Work(); });
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+LiveBase::~LiveBase() {
+    {
+        lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void LiveBase::Reload() {
+    {
+        lock_guard lock(mutex_);
+        reload_ = true;
+    }
+    wake_.notify_one();
+}
+
+void LiveBase::Update(TrC::CatalogueUpdate update, function<void(exception_ptr)> done) {
+    {
+        lock_guard lock(mutex_);
+        updates_.push_back({move(update), move(done)});
+    }
+    wake_.notify_one();
+}
+
+void LiveBase::Work() {
+    unique_lock lock(mutex_);
+    while (true) {
+        const auto woken = [this] {
+            return stop_ || reload_ || !updates_.empty();
+        };
+        // Пока заменённые версии читают, поток просыпается, чтобы удалить их сразу после этого
+        if (snapshots_.RetiredCount() > 0) {
+            wake_.wait_for(lock, RECLAIM_INTERVAL, woken);
+        } else {
+            wake_.wait(lock, woken);
+        }
+        snapshots_.Reclaim();
+        // Изменения, принятые до остановки, тоже применяются: их результата ждут
+        if (!updates_.empty()) {
+            PendingUpdate pending = move(updates_.front());
+            updates_.pop_front();
+            lock.unlock();
+            Apply(pending);
+            lock.lock();
+            continue;
+        }
+        if (stop_) {
+            return;
+        }
+        if (!reload_) {
+            continue;
+        }
+        reload_ = false;
+        lock.unlock();
+        // Запросы продолжают читать прежнюю версию, пока новая загружается
+        try {
+            snapshots_.Publish(LoadBase(path_));
+            ++reloads_;
+            cerr << "Base reloaded from "sv << path_ << endl;
+        } catch (const exception& error) {
+            cerr << error.what() << ", keeping the current version"sv << endl;
+        }
+        lock.lock();
+    }
+}
+
+void LiveBase::Apply(PendingUpdate& pending) {
+    exception_ptr error;
+    try {
+        auto next = make_unique<City>();
+        {
+            const ReadGuard current = snapshots_.Read();
+            next->Build(*current, pending.update);
+        }
+        // Прежнюю версию ещё могут читать: она удалится, когда чтение закончится
+        snapshots_.Publish(move(next));
+    } catch (...) {
+        error = current_exception();
+    }
+    pending.done(error);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "city_registry.h"
+#include "rcu.h"
+
+// База, которую можно заменить новой версией, не прерывая обработку запросов. Запросы читают
+// неизменяемую версию без блокировок (rcu::Snapshots); новая версия загружается или строится
+// из текущей с изменениями в фоновом потоке и публикуется атомарно. Запросы, начатые
+// до замены, заканчиваются на прежней версии, а она удаляется в фоновом потоке, как только
+// её перестанут читать
+class LiveBase {
+public:
+    using ReadGuard = rcu::Snapshots<City>::ReadGuard;
+
+    // Загружает базу path; бросает std::runtime_error, если это не удалось
+    explicit LiveBase(std::string path);
+    LiveBase(const LiveBase&) = delete;
+    LiveBase& operator=(const LiveBase&) = delete;
+    // Читателей к этому моменту быть не должно; незаконченная загрузка дожидается окончания
+    ~LiveBase();
+
+    ReadGuard Read() const {
+        return snapshots_.Read();
+    }
+
+    // Начинает загрузку базы заново из того же файла и возвращает управление сразу. Если базу
+    // не удалось загрузить, остаётся прежняя версия. Запрос во время загрузки выполнится после неё
+    void Reload();
+
+    // Ставит изменения update в очередь и возвращает управление сразу: версию с ними строит из
+    // текущей и публикует фоновый поток, а запросы тем временем читают текущую. После публикации
+    // поток вызывает done с пустым exception_ptr; если изменения противоречат справочнику, текущая
+    // версия остаётся, а done получает исключение TrC::ApplyUpdate. Изменения применяются по одному
+    // в порядке вызовов, поэтому ни одно из них не теряется; загрузка по Reload заменяет базу
+    // файлом, отменяя сделанные до неё изменения
+    void Update(TrC::CatalogueUpdate update, std::function<void(std::exception_ptr)> done);
+
+    // Число опубликованных новых версий
+    uint64_t GetReloadCount() const {
+        return reloads_.load();
+    }
+
+private:
+    struct PendingUpdate {
+        TrC::CatalogueUpdate update;
+        std::function<void(std::exception_ptr)> done;
+    };
+
+    void Work();
+    void Apply(PendingUpdate& pending);
+
+    const std::string path_;
+    rcu::Snapshots<City> snapshots_;
+    std::atomic<uint64_t> reloads_{0};
+
+    // Версии строит и публикует только фоновый поток, поэтому публикации не пересекаются
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool reload_ = false;
+    std::deque<PendingUpdate> updates_;
+    bool stop_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,83 @@
+#include "live_catalogue.h"
+
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace TrC {
+
+using namespace std;
+
+void ApplyUpdate(const TransportCatalogue& base, const CatalogueUpdate& update, TransportCatalogue& next) {
+
+    const unordered_set<string_view> removed_stops(update.remove_stops.begin(), update.remove_stops.end());
+    unordered_map<string_view, const Stop*> replaced_stops;
+    for (const auto& stop : update.add_stops) {
+        replaced_stops[stop.name] = &stop;
+    }
+    
+    for (auto it = base.StopsBegin(); it != base.StopsEnd(); ++it) {
+        if (removed_stops.count(it->name)) {
+            continue;
+        }
+        const auto replaced = replaced_stops.find(it->name);
+        next.AddStop(replaced == replaced_stops.end() ? *it : *replaced->second);
+    }
+    for (const auto& stop : update.add_stops) {
+        if (!removed_stops.count(stop.name)) {
+            next.AddStop(stop);
+        }
+    }
+    
+    // AddDistances не перезаписывает расстояния, поэтому новые добавляются первыми
+    for (const auto& [from, to, distance] : update.distances) {
+        if (!next.StopCount(from) || !next.StopCount(to)) {
+            throw invalid_argument("Distance between unknown stops "s + from + " and "s + to);
+        }
+        next.AddDistances(&next.FindStop(from), &next.FindStop(to), distance);
+    }
+    for (const auto& [stops, distance] : base.GetDistances()) {
+        if (next.StopCount(stops.first->name) && next.StopCount(stops.second->name)) {
+            next.AddDistances(&next.FindStop(stops.first->name), &next.FindStop(stops.second->name), distance);
+        }
+    }
+    
+    auto make_route = [&next](const string& bus_name, auto first, auto last) {
+        vector<Stop*> route;
+        for (; first != last; ++first) {
+            const string_view name = *first;
+            if (!next.StopCount(name)) {
+                throw invalid_argument("Bus "s + bus_name + " refers to unknown stop "s + string(name));
+            }
+            route.push_back(&next.FindStop(name));
+        }
+        return route;
+    };
+    
+    unordered_set<string_view> skipped_buses(update.remove_buses.begin(), update.remove_buses.end());
+    for (const auto& bus : update.add_buses) {
+        skipped_buses.insert(bus.name);
+    }
+    for (auto it = base.BusesBegin(); it != base.BusesEnd(); ++it) {
+        if (skipped_buses.count(it->name)) {
+            continue;
+        }
+        vector<string_view> names;
+        for (const Stop* stop : it->route) {
+            names.push_back(stop->name);
+        }
+        next.AddBus(Bus{it->name, make_route(it->name, names.begin(), names.end()), it->is_ring});
+    }
+    const unordered_set<string_view> removed_buses(update.remove_buses.begin(), update.remove_buses.end());
+    for (const auto& bus : update.add_buses) {
+        if (!removed_buses.count(bus.name)) {
+            next.AddBus(Bus{bus.name, make_route(bus.name, bus.stops.begin(), bus.stops.end()), bus.is_ring});
+        }
+    }
+    
+    next.BuildBusesForStopsIndex();
+    next.BuildSpatialIndex();
+    next.BuildNameIndex();
+}
+
+} // namespace TrC
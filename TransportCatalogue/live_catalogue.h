@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "transport_catalogue.h"
+
+namespace TrC {
+
+// Маршрут, заданный именами остановок
+struct BusDescription {
+    std::string name;
+    std::vector<std::string> stops;
+    bool is_ring = false;
+};
+
+// Набор изменений справочника. Добавление существующей остановки или маршрута заменяет их,
+// заданные расстояния заменяют прежние
+struct CatalogueUpdate {
+    std::vector<Stop> add_stops;
+    std::vector<std::string> remove_stops;
+    std::vector<BusDescription> add_buses;
+    std::vector<std::string> remove_buses;
+    std::vector<std::tuple<std::string, std::string, unsigned>> distances;
+};
+
+// Заполняет пустой справочник next справочником base с применёнными изменениями, включая индексы.
+// Бросает std::invalid_argument, если маршрут ссылается на отсутствующую остановку,
+// и std::out_of_range, если для соседних остановок маршрута не задано расстояние.
+// Изменения во время обработки запросов применяет LiveBase::Update
+void ApplyUpdate(const TransportCatalogue& base, const CatalogueUpdate& update, TransportCatalogue& next);
+
+} // namespace TrC
@@ -1,24 +1,164 @@
+#include <charconv>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
 #include <string_view>
 
 #include "json_reader.h"
+#include "live_base.h"
 #include "map_renderer.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include "server.h"
 #include "transport_router.h"
 
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests [--positions <file>] [--compact|--ndjson]|serve (--socket <path>|--port <n>) [--positions <file>|--workers <n>]] [--input <file>] [--threads <n>] [--memory-report]\n"sv;
+}
+
+// Читает запросы из файла input_path, отображённого в память, или, если путь пуст, из стандартного ввода.
+// Бросает std::runtime_error, если файл не удалось открыть
+json::Document LoadRequests(const std::string& input_path) {
+    if (input_path.empty()) {
+        return json::Load(std::cin);
+    }
+    const io::MappedFile input(input_path);
+    return json::Load(input.GetData());
+}
+
+// В построчном режиме первая строка ввода содержит настройки запроса process_requests без stat_requests
+json::Document ReadSettingsLine(std::istream& input) {
+    std::string line;
+    std::getline(input, line);
+    return json::Load(std::string_view(line));
+}
+
+// Разбирает положительное число из аргумента командной строки
+template <typename Number>
+bool ParseCount(std::string_view value, Number& count) {
+    const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), count);
+    return ec == std::errc() && ptr == value.data() + value.size() && count > 0;
+}
+
+// Обслуживает построчные запросы через сокет до сигнала остановки - в этом процессе или,
+// если processes больше нуля, в стольких дочерних процессах; false, если сокет не открылся.
+// reload вызывается по сигналу SIGHUP
+bool Serve(const server::Address& address, size_t processes, const server::Answer& answer,
+           const std::function<void()>& reload = {}) {
+    try {
+        const server::Listener listener(address);
+        std::cerr << "Serving requests on "sv;
+        if (address.socket_path.empty()) {
+            std::cerr << "127.0.0.1:"sv << address.port << std::endl;
+        } else {
+            std::cerr << address.socket_path << std::endl;
+        }
+        const auto serve = [&listener, &answer, &reload] {
+            server::Server server(listener, answer, parallel::GetThreadCount(), reload);
+            server.Run();
+            return 0;
+        };
+        if (processes > 0) {
+            server::RunProcesses(processes, serve);
+        } else {
+            serve();
+        }
+    } catch (const std::runtime_error& error) {
+        std::cerr << error.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Печатает в stderr оценку памяти справочника, маршрутизатора и дерева JSON запросов
+void PrintMemoryReport(std::string_view stage, const TrC::TransportCatalogue& catalogue,
+                       const router::TransportRouter& router, const JsonReader& reader) {
+    memory::Report report = catalogue.GetMemoryUsage();
+    for (auto& usage : router.GetMemoryUsage()) {
+        report.push_back(std::move(usage));
+    }
+    report.push_back(memory::JsonUsage("json.requests"s, reader.GetQuerys()));
+    
+    std::cerr << "Memory usage after "sv << stage << ":\n"sv;
+    memory::PrintReport(report, std::cerr);
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
+    // Режимы, отвечающие на stat_requests по загруженной базе
+    const bool is_query_mode = mode == "process_requests"sv || mode == "serve"sv;
+    server::Address address;
+    size_t processes = 0;
+    bool has_thread_count = false;
+    std::string positions_path;
+    std::string input_path;
+    bool memory_report = false;
+    json::Format format = json::Format::PRETTY;
+    bool ndjson = false;
+    for (int i = 2; i < argc; ++i) {
+        if (argv[i] == "--positions"sv && i + 1 < argc && is_query_mode) {
+            positions_path = argv[++i];
+        } else if (argv[i] == "--input"sv && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (argv[i] == "--compact"sv && mode == "process_requests"sv) {
+            format = json::Format::COMPACT;
+        } else if (argv[i] == "--ndjson"sv && mode == "process_requests"sv) {
+            ndjson = true;
+        } else if (argv[i] == "--socket"sv && i + 1 < argc && mode == "serve"sv) {
+            address.socket_path = argv[++i];
+        } else if (argv[i] == "--port"sv && i + 1 < argc && mode == "serve"sv) {
+            if (!ParseCount(argv[++i], address.port)) {
+                PrintUsage();
+                return 1;
+            }
+        } else if (argv[i] == "--workers"sv && i + 1 < argc && mode == "serve"sv) {
+            if (!ParseCount(argv[++i], processes)) {
+                PrintUsage();
+                return 1;
+            }
+        } else if (argv[i] == "--threads"sv && i + 1 < argc) {
+            // Число потоков разбора и обработки запросов; по умолчанию - по числу ядер
+            size_t count = 0;
+            if (!ParseCount(argv[++i], count)) {
+                PrintUsage();
+                return 1;
+            }
+            parallel::SetThreadCount(count);
+            has_thread_count = true;
+        } else if (argv[i] == "--memory-report"sv) {
+            memory_report = true;
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+    // Сервер слушает ровно один адрес. Положения автобусов читает один процесс, поэтому
+    // с рабочими процессами они не используются
+    if (mode == "serve"sv && (address.socket_path.empty() == (address.port == 0)
+                              || (processes > 0 && !positions_path.empty()))) {
+        PrintUsage();
+        return 1;
+    }
+    // Сервер принимает сигналы остановки и перезагрузки в цикле событий. Их нужно заблокировать до
+    // запуска любых потоков - загрузки базы, чтения положений автобусов, - иначе сигнал получит один
+    // из них и процесс завершится, не удалив сокет
+    if (mode == "serve"sv) {
+        server::BlockSignals();
+    }
+    // Рабочие процессы сами делят ядра, по умолчанию каждый обрабатывает запросы в одном потоке
+    if (processes > 0 && !has_thread_count) {
+        parallel::SetThreadCount(1);
+    }
     
     TrC::TransportCatalogue catalogue;
     renderer::MapRenderer render;
@@ -26,21 +166,148 @@ int main(int argc, char* argv[]) {
     RequestHandler handler(catalogue, render, graph);
 
     if (mode == "make_base"sv) {
-        JsonReader read(std::cin);
-        read.FillingCatalogue(catalogue, handler);
+        // Запрос make_base может быть большим, поэтому разбирается потоково, без дерева документа
+        JsonReader read;
+        if (input_path.empty()) {
+            read.FillingCatalogue(std::cin, catalogue, handler);
+        } else {
+            try {
+                const io::MappedFile input(input_path);
+                read.FillingCatalogue(input.GetData(), catalogue, handler);
+            } catch (const std::runtime_error& error) {
+                std::cerr << error.what() << std::endl;
+                return 1;
+            }
+        }
         render.SetSettings(read.ReadRenderSettings());
         handler.GraphInit(read.ReadRoutingSettings());
         
-        handler.Serialize(read.ReadSerializationSettings(), read.ReadRoutingSettings());
+        const router::TransportRouter router = handler.MakeTransportRouterWithGraph(read.ReadRoutingSettings());
+        handler.Serialize(read.ReadSerializationSettings(), router);
+        if (memory_report) {
+            PrintMemoryReport("make_base"sv, catalogue, router, read);
+        }
 
-    } else if (mode == "process_requests"sv) {
-        JsonReader read(std::cin);
+    } else if (is_query_mode) {
+        // В построчном режиме запросы читаются из input_path или стандартного ввода по одному
+        std::ifstream lines_file;
+        if (ndjson && !input_path.empty()) {
+            lines_file.open(input_path);
+            if (!lines_file.is_open()) {
+                std::cerr << "Cannot open "sv << input_path << std::endl;
+                return 1;
+            }
+        }
+        std::istream& lines = lines_file.is_open() ? lines_file : std::cin;
+        
+        JsonReader read;
+        try {
+            read.SetQuerys(ndjson ? ReadSettingsLine(lines) : LoadRequests(input_path));
+        } catch (const std::runtime_error& error) {
+            // Файл --input не удалось открыть или отобразить в память, либо запрос не разобран
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+        // Настройки баз читаются до их загрузки: ошибка в них - ошибка запуска, а не запроса
+        bool has_cities = false;
+        std::map<std::string, std::string, std::less<>> cities;
+        size_t memory_budget = CityRegistry::UNLIMITED;
+        std::string base_path;
+        try {
+            has_cities = read.HasCities();
+            if (has_cities) {
+                cities = read.ReadCities();
+                memory_budget = read.ReadMemoryBudget();
+            } else {
+                base_path = read.ReadSerializationSettings();
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid or missing serialization_settings"sv << std::endl;
+            PrintUsage();
+            return 1;
+        }
+        if (has_cities) {
+            // Положения автобусов и отчёт о памяти относятся к одной базе, а не к реестру городов
+            if (!positions_path.empty() || memory_report) {
+                PrintUsage();
+                return 1;
+            }
+            // Базы городов загружаются по мере обращения к ним
+            CityRegistry registry(std::move(cities), memory_budget);
+            if (mode == "serve"sv) {
+                // Рабочие процессы получают города, загруженные до их запуска, без копирования;
+                // загруженные каждым процессом после запуска заняли бы память в каждом
+                if (processes > 0) {
+                    registry.Preload();
+                }
+                return Serve(address, processes, [&registry](std::string_view line, const server::Respond& respond) {
+                    respond(MakeLineReport(line, registry));
+                }) ? 0 : 1;
+            } else if (ndjson) {
+                ServeRequests(lines, std::cout, registry);
+            } else {
+                read.WriteReport(std::cout, registry, format);
+            }
+            return 0;
+        }
+        // Сервер в одном процессе без положений автобусов заменяет базу по SIGHUP и изменяет её
+        // по запросам Update, не прерывая обработку запросов: make_base может перестроить файл
+        // базы во время работы сервера
+        if (mode == "serve"sv && processes == 0 && positions_path.empty()) {
+            std::unique_ptr<LiveBase> base;
+            try {
+                base = std::make_unique<LiveBase>(base_path);
+            } catch (const std::runtime_error&) {
+                std::cerr << "Deserialize ERROR" << std::endl;
+                return 1;
+            }
+            if (memory_report) {
+                const LiveBase::ReadGuard city = base->Read();
+                PrintMemoryReport("deserialization"sv, city->catalogue, city->router, read);
+            }
+            return Serve(address, processes, [&base](std::string_view line, const server::Respond& respond) {
+                MakeLineReport(line, *base, respond);
+            }, [&base] {
+                base->Reload();
+            }) ? 0 : 1;
+        }
         router::TransportRouter router(catalogue, graph);
-        if (handler.Deserialize(read.ReadSerializationSettings(), router)) {
-            json::Print(read.MakeReport(handler, router), std::cout);
+        if (handler.Deserialize(base_path, router)) {
+            if (memory_report) {
+                PrintMemoryReport("deserialization"sv, catalogue, router, read);
+            }
+            // Положения автобусов загружаются параллельно с обработкой запросов
+            std::unique_ptr<vehicles::PositionTable> positions;
+            std::unique_ptr<vehicles::PositionFeed> feed;
+            if (!positions_path.empty()) {
+                positions = std::make_unique<vehicles::PositionTable>(catalogue.GetBuses().size());
+                feed = std::make_unique<vehicles::PositionFeed>(catalogue, *positions);
+                try {
+                    feed->Start(positions_path);
+                } catch (const std::runtime_error& error) {
+                    std::cerr << error.what() << std::endl;
+                    return 1;
+                }
+                handler.SetPositions(positions.get());
+            }
+            if (mode == "serve"sv) {
+                if (!Serve(address, processes, [&handler, &router](std::string_view line, const server::Respond& respond) {
+                        respond(MakeLineReport(line, handler, router));
+                    })) {
+                    return 1;
+                }
+            } else if (ndjson) {
+                ServeRequests(lines, std::cout, handler, router);
+            } else {
+                read.WriteReport(std::cout, handler, router, format);
+            }
         }
         else {
             std::cerr << "Deserialize ERROR" << std::endl;
+            // Сервер без базы не запускается, и это ошибка запуска
+            if (mode == "serve"sv) {
+                return 1;
+            }
         }
 
     } else {
@@ -8,6 +8,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <optional>
+#include <string>
 #include <vector>
 #include <map>
 
@@ -118,6 +119,15 @@ public:
         return settings_;
     }
     
+    // Готовая карта в формате SVG, см. RequestHandler::GetMap
+    void SetMap(std::string map) {
+        map_ = std::move(map);
+    }
+    
+    const std::string& GetMap() const {
+        return map_;
+    }
+    
     svg::Polyline DrawRoute(const std::vector<svg::Point>& points, int i) const;
     std::pair<svg::Text, svg::Text> DrawName(svg::Point point, std::string_view route_name, int i) const;
     svg::Circle DrawStop(svg::Point point) const;
@@ -134,6 +144,7 @@ public:
     
 private:
     RenderSettings settings_;
+    std::string map_;
 };
     
 } // namespace renderer
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "memory_usage.h"
+
+#include <iomanip>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace memory {
+
+using namespace std;
+
+namespace {
+
+void AddNode(const json::Node& node, Usage& usage) {
+    ++usage.count;
+    if (node.IsString()) {
+        usage.bytes += StringBytes(node.AsString());
+    }
+    else if (node.IsArray()) {
+        usage.bytes += VectorBytes(node.AsArray());
+        for (const auto& item : node.AsArray()) {
+            AddNode(item, usage);
+        }
+    }
+    else if (node.IsDict()) {
+        usage.bytes += node.AsDict().capacity() * sizeof(json::Dict::value_type);
+        for (const auto& [key, value] : node.AsDict()) {
+            usage.bytes += StringBytes(key);
+            AddNode(value, usage);
+        }
+    }
+}
+
+} // namespace
+
+Usage JsonUsage(string name, const json::Document& document) {
+    Usage usage{move(name), 0, 0};
+    AddNode(document.GetRoot(), usage);
+    return usage;
+}
+
+size_t HeapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+void PrintReport(const Report& report, ostream& output) {
+    size_t width = 0;
+    size_t total = 0;
+    for (const auto& usage : report) {
+        width = max(width, usage.name.size());
+        total += usage.bytes;
+    }
+    width = max(width, "heap in use (malloc)"s.size());
+    
+    auto print_line = [&](const string& name, size_t bytes) {
+        output << left << setw(width) << name << right << setw(14) << bytes << " bytes"s;
+    };
+    for (const auto& usage : report) {
+        print_line(usage.name, usage.bytes);
+        output << setw(12) << usage.count << " entries\n"s;
+    }
+    print_line("total"s, total);
+    output << '\n';
+    if (const size_t heap = HeapInUse()) {
+        print_line("heap in use (malloc)"s, heap);
+        output << '\n';
+    }
+}
+
+} // namespace memory
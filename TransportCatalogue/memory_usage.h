@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "json.h"
+
+namespace memory {
+
+// Оценка памяти, занимаемой структурой данных: размер её буферов в куче без накладных
+// расходов распределителя памяти и число хранимых элементов
+struct Usage {
+    std::string name;
+    size_t bytes = 0;
+    size_t count = 0;
+};
+
+using Report = std::vector<Usage>;
+
+template <typename T, typename Allocator>
+size_t VectorBytes(const std::vector<T, Allocator>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+// Память строки в куче; короткие строки хранятся внутри объекта и памяти в куче не занимают
+inline size_t StringBytes(const std::string& value) {
+    const char* data = value.data();
+    const char* object = reinterpret_cast<const char*>(&value);
+    if (data >= object && data < object + sizeof(value)) {
+        return 0;
+    }
+    return value.capacity() + 1;
+}
+
+// Оценка по устройству std::deque в libstdc++: элементы хранятся блоками по 512 байт
+// (или по одному, если элемент больше), указатели на блоки - в отдельном массиве
+template <typename T>
+size_t DequeBytes(const std::deque<T>& values) {
+    const size_t per_block = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+    const size_t blocks = values.size() / per_block + 1;
+    return blocks * per_block * sizeof(T) + std::max<size_t>(8, blocks + 2) * sizeof(T*);
+}
+
+// Память дерева JSON: узлы, строки, массивы и словари; count - число узлов
+Usage JsonUsage(std::string name, const json::Document& document);
+
+// Память, выделенная через malloc и ещё не освобождённая, или 0, если её нельзя узнать
+size_t HeapInUse();
+
+void PrintReport(const Report& report, std::ostream& output);
+
+} // namespace memory
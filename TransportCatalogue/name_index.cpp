@@ -0,0 +1,216 @@
+#include "name_index.h"
+
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+
+namespace search {
+
+using namespace std;
+
+namespace {
+
+// Длина символа UTF-8 по его первому байту; некорректные байты считаются отдельными символами
+size_t CharLength(unsigned char lead) {
+    if (lead >= 0xF0 && lead < 0xF8) {
+        return 4;
+    }
+    if (lead >= 0xE0 && lead < 0xF0) {
+        return 3;
+    }
+    if (lead >= 0xC0 && lead < 0xE0) {
+        return 2;
+    }
+    return 1;
+}
+
+bool IsContinuation(unsigned char byte) {
+    return (byte & 0xC0) == 0x80;
+}
+
+} // namespace
+
+NameIndex::NameIndex(vector<pair<string_view, uint32_t>> names) {
+    sort(names.begin(), names.end());
+    names.erase(unique(names.begin(), names.end()), names.end());
+
+    // Узлы нумеруются в порядке обхода в ширину, поэтому рёбра каждого узла
+    // дописываются в массивы сразу после рёбер предыдущего
+    struct Range {
+        size_t begin;
+        size_t end;
+        size_t depth;
+    };
+    queue<Range> nodes;
+    nodes.push({0, names.size(), 0});
+    uint32_t next_id = 1;
+    while (!nodes.empty()) {
+        const auto [begin, end, depth] = nodes.front();
+        nodes.pop();
+
+        child_offsets_.push_back(static_cast<uint32_t>(labels_.size()));
+        value_offsets_.push_back(static_cast<uint32_t>(values_.size()));
+
+        size_t i = begin;
+        // Имена, оканчивающиеся в этом узле, идут в отсортированном диапазоне первыми
+        for (; i < end && names[i].first.size() == depth; ++i) {
+            values_.push_back(names[i].second);
+        }
+        while (i < end) {
+            const char label = names[i].first[depth];
+            size_t j = i;
+            while (j < end && names[j].first[depth] == label) {
+                ++j;
+            }
+            labels_.push_back(label);
+            targets_.push_back(next_id++);
+            nodes.push({i, j, depth + 1});
+            i = j;
+        }
+    }
+    child_offsets_.push_back(static_cast<uint32_t>(labels_.size()));
+    value_offsets_.push_back(static_cast<uint32_t>(values_.size()));
+}
+
+NameIndex::NameIndex(vector<uint32_t> child_offsets, string labels, vector<uint32_t> targets,
+                     vector<uint32_t> value_offsets, vector<uint32_t> values)
+    : child_offsets_(move(child_offsets)), labels_(move(labels)), targets_(move(targets))
+    , value_offsets_(move(value_offsets)), values_(move(values)) {
+    // Массивы приходят из файла базы. Смещения должны задавать полуинтервалы внутри labels и
+    // values, а рёбра - вести к узлам с большими номерами, как при обходе в ширину: иначе поиск
+    // читал бы за границами массивов или зацикливался
+    const size_t nodes = child_offsets_.size();
+    if (nodes < 2 || value_offsets_.size() != nodes || labels_.size() != targets_.size()
+        || child_offsets_.front() != 0 || child_offsets_.back() != labels_.size()
+        || value_offsets_.front() != 0 || value_offsets_.back() != values_.size()
+        || !is_sorted(child_offsets_.begin(), child_offsets_.end())
+        || !is_sorted(value_offsets_.begin(), value_offsets_.end())) {
+        throw invalid_argument("Name index arrays are inconsistent");
+    }
+    for (uint32_t node = 0; node + 1 < nodes; ++node) {
+        for (uint32_t i = child_offsets_[node]; i < child_offsets_[node + 1]; ++i) {
+            if (targets_[i] <= node || targets_[i] >= nodes - 1) {
+                throw invalid_argument("Name index arrays are inconsistent");
+            }
+        }
+    }
+}
+
+uint32_t NameIndex::Child(uint32_t node, char label) const {
+    const auto first = labels_.begin() + child_offsets_[node];
+    const auto last = labels_.begin() + child_offsets_[node + 1];
+    // Имена отсортированы через char_traits, сравнивающие байты как беззнаковые
+    const auto it = lower_bound(first, last, label, [](char lhs, char rhs) {
+        return static_cast<unsigned char>(lhs) < static_cast<unsigned char>(rhs);
+    });
+    if (it == last || *it != label) {
+        return NO_NODE;
+    }
+    return targets_[it - labels_.begin()];
+}
+
+uint32_t NameIndex::Walk(uint32_t node, string_view path) const {
+    for (const char label : path) {
+        if (node == NO_NODE) {
+            break;
+        }
+        node = Child(node, label);
+    }
+    return node;
+}
+
+void NameIndex::CollectSubtree(uint32_t node, size_t limit, vector<uint32_t>& result) const {
+    if (result.size() >= limit) {
+        return;
+    }
+    for (uint32_t i = value_offsets_[node]; i < value_offsets_[node + 1] && result.size() < limit; ++i) {
+        result.push_back(values_[i]);
+    }
+    for (uint32_t i = child_offsets_[node]; i < child_offsets_[node + 1] && result.size() < limit; ++i) {
+        CollectSubtree(targets_[i], limit, result);
+    }
+}
+
+template <typename Action>
+void NameIndex::ForEachCharChild(uint32_t node, Action action) const {
+    for (uint32_t i = child_offsets_[node]; i < child_offsets_[node + 1]; ++i) {
+        const size_t length = CharLength(static_cast<unsigned char>(labels_[i]));
+        // Спускаемся по байтам продолжения, пока символ не закончится
+        auto descend = [&](auto& self, uint32_t current, size_t left) -> void {
+            if (left == 0) {
+                action(current);
+                return;
+            }
+            for (uint32_t j = child_offsets_[current]; j < child_offsets_[current + 1]; ++j) {
+                if (IsContinuation(static_cast<unsigned char>(labels_[j]))) {
+                    self(self, targets_[j], left - 1);
+                }
+            }
+        };
+        descend(descend, targets_[i], length - 1);
+    }
+}
+
+void NameIndex::FindSimilar(uint32_t node, string_view rest, bool can_edit, vector<uint32_t>& result) const {
+    if (!can_edit) {
+        node = Walk(node, rest);
+        if (node != NO_NODE) {
+            result.insert(result.end(), values_.begin() + value_offsets_[node], values_.begin() + value_offsets_[node + 1]);
+        }
+        return;
+    }
+
+    if (rest.empty()) {
+        result.insert(result.end(), values_.begin() + value_offsets_[node], values_.begin() + value_offsets_[node + 1]);
+        // Лишний символ в конце имени
+        ForEachCharChild(node, [&](uint32_t child) {
+            result.insert(result.end(), values_.begin() + value_offsets_[child], values_.begin() + value_offsets_[child + 1]);
+        });
+        return;
+    }
+
+    const size_t length = min(CharLength(static_cast<unsigned char>(rest.front())), rest.size());
+    const string_view current = rest.substr(0, length);
+    const string_view tail = rest.substr(length);
+
+    if (const uint32_t child = Walk(node, current); child != NO_NODE) {
+        FindSimilar(child, tail, true, result);
+    }
+    // Символ запроса отсутствует в имени
+    FindSimilar(node, tail, false, result);
+    ForEachCharChild(node, [&](uint32_t child) {
+        // Символ запроса заменён другим
+        FindSimilar(child, tail, false, result);
+        // В имени есть лишний символ
+        FindSimilar(child, rest, false, result);
+    });
+}
+
+vector<uint32_t> NameIndex::FindByPrefix(string_view prefix, size_t limit) const {
+    vector<uint32_t> result;
+    if (NodeCount() == 0 || limit == 0) {
+        return result;
+    }
+    const uint32_t node = Walk(0, prefix);
+    if (node != NO_NODE) {
+        CollectSubtree(node, limit, result);
+    }
+    return result;
+}
+
+vector<uint32_t> NameIndex::FindSimilar(string_view name, size_t limit) const {
+    vector<uint32_t> result;
+    if (NodeCount() == 0 || limit == 0) {
+        return result;
+    }
+    FindSimilar(0, name, true, result);
+    sort(result.begin(), result.end());
+    result.erase(unique(result.begin(), result.end()), result.end());
+    if (result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
+
+} // namespace search
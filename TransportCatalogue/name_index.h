@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace search {
+
+// Префиксное дерево имён, хранящееся в плоских массивах. Рёбра помечены байтами,
+// рёбра узла n занимают полуинтервал [child_offsets[n], child_offsets[n+1]) массивов
+// labels и targets и отсортированы по метке. Каждому имени сопоставлено значение
+// uint32_t, значения имён, оканчивающихся в узле n, лежат в
+// [value_offsets[n], value_offsets[n+1]) массива values. Корень - узел 0.
+class NameIndex {
+public:
+    NameIndex() = default;
+
+    explicit NameIndex(std::vector<std::pair<std::string_view, uint32_t>> names);
+
+    // Восстанавливает дерево из массивов, сохранённых в базе; бросает std::invalid_argument,
+    // если они не согласованы между собой
+    NameIndex(std::vector<uint32_t> child_offsets, std::string labels, std::vector<uint32_t> targets,
+              std::vector<uint32_t> value_offsets, std::vector<uint32_t> values);
+
+    // Значения имён, начинающихся с prefix, в лексикографическом порядке имён, не более limit
+    std::vector<uint32_t> FindByPrefix(std::string_view prefix, size_t limit) const;
+
+    // Значения имён на расстоянии Левенштейна не больше 1 от name. Расстояние считается
+    // в символах UTF-8, а не в байтах. Порядок результата - по возрастанию значения
+    std::vector<uint32_t> FindSimilar(std::string_view name, size_t limit) const;
+
+    size_t NodeCount() const {
+        return child_offsets_.empty() ? 0 : child_offsets_.size() - 1;
+    }
+
+    const std::vector<uint32_t>& GetChildOffsets() const {
+        return child_offsets_;
+    }
+    const std::string& GetLabels() const {
+        return labels_;
+    }
+    const std::vector<uint32_t>& GetTargets() const {
+        return targets_;
+    }
+    const std::vector<uint32_t>& GetValueOffsets() const {
+        return value_offsets_;
+    }
+    const std::vector<uint32_t>& GetValues() const {
+        return values_;
+    }
+
+    size_t GetMemoryUsage() const {
+        return labels_.capacity() + (child_offsets_.capacity() + targets_.capacity() + value_offsets_.capacity()
+            + values_.capacity()) * sizeof(uint32_t);
+    }
+
+private:
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+    uint32_t Child(uint32_t node, char label) const;
+    uint32_t Walk(uint32_t node, std::string_view path) const;
+    void CollectSubtree(uint32_t node, size_t limit, std::vector<uint32_t>& result) const;
+
+    // Вызывает action для каждого узла, достижимого из node по одному полному символу UTF-8
+    template <typename Action>
+    void ForEachCharChild(uint32_t node, Action action) const;
+
+    void FindSimilar(uint32_t node, std::string_view rest, bool can_edit, std::vector<uint32_t>& result) const;
+
+    std::vector<uint32_t> child_offsets_;
+    std::string labels_;
+    std::vector<uint32_t> targets_;
+    std::vector<uint32_t> value_offsets_;
+    std::vector<uint32_t> values_;
+};
+
+} // namespace search
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace parallel {
+
+namespace detail {
+
+inline std::atomic<size_t> thread_count{0};
+
+} // namespace detail
+
+// Число потоков параллельной обработки; по умолчанию - число ядер
+inline size_t GetThreadCount() {
+    const size_t count = detail::thread_count.load(std::memory_order_relaxed);
+    return count ? count : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Задаёт число потоков; 0 возвращает значение по умолчанию
+inline void SetThreadCount(size_t count) {
+    detail::thread_count.store(count, std::memory_order_relaxed);
+}
+
+// Делит полуинтервал [0, count) на непрерывные части - по одной на поток, но не меньше
+// min_chunk элементов - и вызывает func(begin, end) для каждой части. Первая часть
+// обрабатывается в вызывающем потоке, остальные - в отдельных. Возвращает результаты вызовов
+// в порядке частей, поэтому он не зависит от числа потоков. Исключение пробрасывается после
+// завершения всех частей; если их несколько, то из первой по порядку части
+template <typename Func>
+auto MapChunks(size_t count, Func&& func, size_t min_chunk = 1) {
+    using Result = std::invoke_result_t<Func&, size_t, size_t>;
+    const size_t chunks = std::clamp<size_t>(count / std::max<size_t>(min_chunk, 1), 1, GetThreadCount());
+    std::vector<std::future<Result>> futures;
+    futures.reserve(chunks - 1);
+    for (size_t i = 1; i < chunks; ++i) {
+        futures.push_back(std::async(std::launch::async, [&func, begin = count * i / chunks,
+                                                          end = count * (i + 1) / chunks] {
+            return func(begin, end);
+        }));
+    }
+    std::vector<Result> results;
+    results.reserve(chunks);
+    results.push_back(func(0, count / chunks));
+    for (auto& future : futures) {
+        results.push_back(future.get());
+    }
+    return results;
+}
+
+// То же для func без результата
+template <typename Func>
+void ForEachChunk(size_t count, Func&& func, size_t min_chunk = 1) {
+    MapChunks(count, [&func](size_t begin, size_t end) {
+        func(begin, end);
+        return true;
+    }, min_chunk);
+}
+
+// Выполняет независимые задачи одновременно, каждую в своём потоке, если потоков хватает
+template <typename... Tasks>
+void Invoke(Tasks&&... tasks) {
+    const std::vector<std::function<void()>> all{std::forward<Tasks>(tasks)...};
+    ForEachChunk(all.size(), [&all](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            all[i]();
+        }
+    });
+}
+
+// Вычисляет func(i) для i из [0, count) в нескольких потоках и передаёт результаты
+// consume(i, result) в вызывающем потоке строго по порядку i. Потоки берут следующий номер,
+// как только освобождаются, но опережают consume не более чем на window результатов,
+// поэтому в памяти одновременно не больше window результатов. Исключение из func(i)
+// пробрасывается, когда до i доходит очередь; остальные потоки при этом останавливаются
+template <typename Func, typename Consume>
+void ForEachOrdered(size_t count, Func&& func, Consume&& consume, size_t window) {
+    using Result = std::invoke_result_t<Func&, size_t>;
+    const size_t thread_count = std::min(GetThreadCount(), count);
+    if (thread_count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            consume(i, func(i));
+        }
+        return;
+    }
+    window = std::max(window, thread_count);
+    
+    struct Slot {
+        std::optional<Result> result;
+        std::exception_ptr error;
+    };
+    std::vector<Slot> slots(window);
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable space;
+    size_t next = 0;
+    size_t consumed = 0;
+    bool stop = false;
+    
+    auto work = [&] {
+        std::unique_lock lock(mutex);
+        while (true) {
+            space.wait(lock, [&] {
+                return stop || next == count || next < consumed + window;
+            });
+            if (stop || next == count) {
+                return;
+            }
+            const size_t i = next++;
+            lock.unlock();
+            Slot slot;
+            try {
+                slot.result.emplace(func(i));
+            } catch (...) {
+                slot.error = std::current_exception();
+            }
+            lock.lock();
+            slots[i % window] = std::move(slot);
+            ready.notify_all();
+        }
+    };
+    
+    std::vector<std::thread> threads;
+    // Потоки останавливаются и при нормальном завершении, и при исключении
+    struct Joiner {
+        std::vector<std::thread>& threads;
+        std::mutex& mutex;
+        std::condition_variable& space;
+        bool& stop;
+        ~Joiner() {
+            {
+                std::lock_guard lock(mutex);
+                stop = true;
+            }
+            space.notify_all();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+    } joiner{threads, mutex, space, stop};
+    threads.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads.emplace_back(work);
+    }
+    
+    for (size_t i = 0; i < count; ++i) {
+        Slot slot;
+        {
+            std::unique_lock lock(mutex);
+            Slot& current = slots[i % window];
+            ready.wait(lock, [&current] {
+                return current.result || current.error;
+            });
+            slot = std::move(current);
+            current = Slot{};
+            consumed = i + 1;
+        }
+        space.notify_all();
+        if (slot.error) {
+            std::rethrow_exception(slot.error);
+        }
+        consume(i, std::move(*slot.result));
+    }
+}
+
+} // namespace parallel
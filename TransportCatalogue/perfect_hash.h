@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace perfect_hash {
+
+// Хэш по длине строки и трём её байтам: первому, среднему и последнему. Для коротких ключей
+// схемы этого достаточно, а seed подбирается так, чтобы ключи набора не сталкивались
+constexpr uint32_t Hash(std::string_view key, uint32_t seed) {
+    uint32_t hash = (seed ^ static_cast<uint32_t>(key.size())) * 0x01000193u;
+    if (!key.empty()) {
+        hash = (hash ^ static_cast<unsigned char>(key.front())) * 0x01000193u;
+        hash = (hash ^ static_cast<unsigned char>(key[key.size() / 2])) * 0x01000193u;
+        hash = (hash ^ static_cast<unsigned char>(key.back())) * 0x01000193u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+constexpr size_t TableSize(size_t count) {
+    size_t size = 1;
+    while (size < 2 * count) {
+        size *= 2;
+    }
+    return size;
+}
+
+// Отображение фиксированного набора строк в их номера в наборе. Таблица без коллизий строится
+// при компиляции, поиск - одно вычисление хэша и одно сравнение строк
+template <size_t N>
+class Set {
+public:
+    static constexpr size_t NOT_FOUND = N;
+
+    constexpr explicit Set(const std::array<std::string_view, N>& keys) : keys_(keys) {
+        for (seed_ = 0; !TryBuild(); ++seed_) {
+            if (seed_ == MAX_SEED) {
+                // При вычислении во время компиляции исключение становится ошибкой компиляции
+                throw std::logic_error("Perfect hash seed not found");
+            }
+        }
+    }
+
+    // Номер key в наборе или NOT_FOUND
+    constexpr size_t Find(std::string_view key) const {
+        const size_t index = slots_[Hash(key, seed_) & (TABLE_SIZE - 1)];
+        return index != NOT_FOUND && keys_[index] == key ? index : NOT_FOUND;
+    }
+
+private:
+    static constexpr size_t TABLE_SIZE = TableSize(N);
+    static constexpr uint32_t MAX_SEED = 1u << 16;
+
+    constexpr bool TryBuild() {
+        for (size_t& slot : slots_) {
+            slot = NOT_FOUND;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            size_t& slot = slots_[Hash(keys_[i], seed_) & (TABLE_SIZE - 1)];
+            if (slot != NOT_FOUND) {
+                return false;
+            }
+            slot = i;
+        }
+        return true;
+    }
+
+    std::array<std::string_view, N> keys_;
+    std::array<size_t, TABLE_SIZE> slots_{};
+    uint32_t seed_ = 0;
+};
+
+} // namespace perfect_hash
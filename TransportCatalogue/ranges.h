@@ -22,6 +22,12 @@ public:
     It end() const {
         return end_;
     }
+    size_t size() const {
+        return std::distance(begin_, end_);
+    }
+    bool empty() const {
+        return begin_ == end_;
+    }
 
 private:
     It begin_;
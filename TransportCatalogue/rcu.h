@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace rcu {
+
+// Число слотов читателей: читающие сверх него ждут, пока слот освободится
+inline constexpr size_t MAX_READERS = 256;
+
+// Неизменяемые версии объекта типа T, публикуемые через атомарно заменяемый указатель.
+// Читатели не берут блокировок: они объявляют текущую эпоху в своём слоте и читают указатель.
+// Заменённая версия удаляется, когда не остаётся читателей, объявивших эпоху не позже её замены.
+template <typename T>
+class Snapshots {
+private:
+    static constexpr uint64_t IDLE = std::numeric_limits<uint64_t>::max();
+
+    struct alignas(64) Slot {
+        std::atomic<bool> busy{false};
+        std::atomic<uint64_t> epoch{IDLE};
+    };
+
+public:
+    // Доступ читателя к версии; версия не будет удалена, пока существует объект ReadGuard
+    class ReadGuard {
+    public:
+        ReadGuard(const T* value, Slot* slot) : value_{value}, slot_{slot} {
+        }
+        ReadGuard(ReadGuard&& other) noexcept : value_{other.value_}, slot_{std::exchange(other.slot_, nullptr)} {
+        }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+        ~ReadGuard() {
+            if (slot_) {
+                slot_->epoch.store(IDLE, std::memory_order_release);
+                slot_->busy.store(false, std::memory_order_release);
+            }
+        }
+
+        const T& operator*() const {
+            return *value_;
+        }
+        const T* operator->() const {
+            return value_;
+        }
+        const T* Get() const {
+            return value_;
+        }
+
+    private:
+        const T* value_;
+        Slot* slot_;
+    };
+
+    explicit Snapshots(std::unique_ptr<const T> initial) : current_{initial.release()} {
+    }
+
+    Snapshots(const Snapshots&) = delete;
+    Snapshots& operator=(const Snapshots&) = delete;
+
+    // К моменту разрушения читателей быть не должно
+    ~Snapshots() {
+        delete current_.load();
+        for (const auto& [epoch, value] : retired_) {
+            delete value;
+        }
+    }
+
+    ReadGuard Read() const {
+        Slot& slot = AcquireSlot();
+        // Объявление эпохи должно стать видимым писателю раньше, чем читается указатель
+        slot.epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        return ReadGuard(current_.load(std::memory_order_seq_cst), &slot);
+    }
+
+    // Публикует новую версию; предыдущая удаляется, как только её перестанут читать
+    void Publish(std::unique_ptr<const T> next) {
+        std::lock_guard guard(writer_mutex_);
+        const T* previous = current_.exchange(next.release(), std::memory_order_seq_cst);
+        retired_.emplace_back(epoch_.fetch_add(1, std::memory_order_seq_cst), previous);
+        ReclaimLocked();
+    }
+
+    // Удаляет заменённые версии, которые больше никто не читает
+    void Reclaim() {
+        std::lock_guard guard(writer_mutex_);
+        ReclaimLocked();
+    }
+
+    // Число заменённых, но ещё не удалённых версий
+    size_t RetiredCount() const {
+        std::lock_guard guard(writer_mutex_);
+        return retired_.size();
+    }
+
+private:
+    // Чтение занимает слот на время одного запроса, поэтому, если все слоты заняты, читатель
+    // уступает процессор и ищет снова, а не отказывает в чтении
+    Slot& AcquireSlot() const {
+        const size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        while (true) {
+            for (size_t i = 0; i < MAX_READERS; ++i) {
+                Slot& slot = slots_[(start + i) % MAX_READERS];
+                bool expected = false;
+                if (!slot.busy.load(std::memory_order_relaxed)
+                    && slot.busy.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                    return slot;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    void ReclaimLocked() {
+        uint64_t min_epoch = IDLE;
+        for (const Slot& slot : slots_) {
+            min_epoch = std::min(min_epoch, slot.epoch.load(std::memory_order_seq_cst));
+        }
+        auto it = retired_.begin();
+        for (; it != retired_.end() && it->first < min_epoch; ++it) {
+            delete it->second;
+        }
+        retired_.erase(retired_.begin(), it);
+    }
+
+    mutable std::array<Slot, MAX_READERS> slots_;
+    std::atomic<uint64_t> epoch_{1};
+    std::atomic<const T*> current_;
+    mutable std::mutex writer_mutex_;
+    // Заменённые версии в порядке возрастания эпохи замены
+    std::vector<std::pair<uint64_t, const T*>> retired_;
+};
+
+} // namespace rcu
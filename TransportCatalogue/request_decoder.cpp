@@ -0,0 +1,263 @@
+#include "request_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+
+#include "perfect_hash.h"
+
+namespace requests {
+
+using namespace std;
+
+namespace {
+
+constexpr array<string_view, 7> BASE_FIELD_NAMES{
+    "type"sv, "name"sv, "latitude"sv, "longitude"sv, "road_distances"sv, "stops"sv, "is_roundtrip"sv,
+};
+constexpr perfect_hash::Set<7> BASE_FIELDS(BASE_FIELD_NAMES);
+
+constexpr perfect_hash::Set<8> STAT_TYPES({
+    "Stop"sv, "Bus"sv, "Route"sv, "NearestStops"sv, "StopsInArea"sv, "SearchNames"sv, "BusPositions"sv, "Map"sv,
+});
+
+// Бит поля в масках встреченных и обязательных полей
+constexpr uint32_t Bit(size_t field) {
+    return 1u << field;
+}
+
+} // namespace
+
+void BaseRequestDecoder::StartDict() {
+    if (extra_builder_) {
+        extra_builder_->StartDict();
+        ++extra_depth_;
+    }
+    else if (depth_ == 0) {
+        depth_ = REQUEST_DEPTH;
+    }
+    else if (depth_ == REQUEST_DEPTH && field_ == ROAD_DISTANCES) {
+        depth_ = FIELD_DEPTH;
+    }
+    else if (depth_ == REQUEST_DEPTH && field_ == UNKNOWN) {
+        extra_builder_.emplace();
+        extra_builder_->StartDict();
+        extra_depth_ = 1;
+    }
+    else {
+        ThrowUnexpected();
+    }
+}
+
+void BaseRequestDecoder::EndDict() {
+    if (extra_builder_) {
+        extra_builder_->EndDict();
+        if (--extra_depth_ == 0) {
+            FinishExtra();
+        }
+    }
+    else if (depth_ == FIELD_DEPTH && field_ == ROAD_DISTANCES) {
+        // Повтор остановки в road_distances - такая же ошибка, как повтор ключа в любом словаре
+        distance_names_.clear();
+        for (const auto& distance : request_.road_distances) {
+            distance_names_.push_back(distance.stop_name);
+        }
+        sort(distance_names_.begin(), distance_names_.end());
+        if (const auto it = adjacent_find(distance_names_.begin(), distance_names_.end()); it != distance_names_.end()) {
+            throw json::ParsingError("Duplicate key '"s + string(*it) + "' have been found"s);
+        }
+        depth_ = REQUEST_DEPTH;
+    }
+    else if (depth_ == REQUEST_DEPTH) {
+        CheckRequired();
+        depth_ = 0;
+        is_complete_ = true;
+    }
+    else {
+        ThrowUnexpected();
+    }
+}
+
+void BaseRequestDecoder::StartArray() {
+    if (extra_builder_) {
+        extra_builder_->StartArray();
+        ++extra_depth_;
+    }
+    else if (depth_ == REQUEST_DEPTH && field_ == STOPS) {
+        depth_ = FIELD_DEPTH;
+    }
+    else if (depth_ == REQUEST_DEPTH && field_ == UNKNOWN) {
+        extra_builder_.emplace();
+        extra_builder_->StartArray();
+        extra_depth_ = 1;
+    }
+    else {
+        ThrowUnexpected();
+    }
+}
+
+void BaseRequestDecoder::EndArray() {
+    if (extra_builder_) {
+        extra_builder_->EndArray();
+        if (--extra_depth_ == 0) {
+            FinishExtra();
+        }
+    }
+    else if (depth_ == FIELD_DEPTH && field_ == STOPS) {
+        depth_ = REQUEST_DEPTH;
+    }
+    else {
+        ThrowUnexpected();
+    }
+}
+
+void BaseRequestDecoder::Key(string_view key) {
+    if (extra_builder_) {
+        extra_builder_->Key(key);
+    }
+    else if (depth_ == REQUEST_DEPTH) {
+        field_ = static_cast<Field>(BASE_FIELDS.Find(key));
+        if (field_ == UNKNOWN) {
+            extra_key_ = key;
+        }
+        else if (seen_ & Bit(field_)) {
+            throw json::ParsingError("Duplicate key '"s + string(key) + "' have been found"s);
+        }
+        else {
+            seen_ |= Bit(field_);
+        }
+    }
+    else if (depth_ == FIELD_DEPTH && field_ == ROAD_DISTANCES) {
+        // Расстояние добавляется сразу с именем остановки, значение приходит следующим событием
+        request_.road_distances.push_back({0, string(key)});
+    }
+    else {
+        ThrowUnexpected();
+    }
+}
+
+void BaseRequestDecoder::Value(nullptr_t value) {
+    AddExtra(value);
+}
+
+void BaseRequestDecoder::Value(bool value) {
+    if (!extra_builder_ && depth_ == REQUEST_DEPTH && field_ == IS_ROUNDTRIP) {
+        request_.is_roundtrip = value;
+    }
+    else {
+        AddExtra(value);
+    }
+}
+
+void BaseRequestDecoder::Value(int value) {
+    if (extra_builder_) {
+        AddExtra(value);
+    }
+    else if (depth_ == FIELD_DEPTH && field_ == ROAD_DISTANCES) {
+        request_.road_distances.back().distance = static_cast<unsigned>(value);
+    }
+    else {
+        // Целые координаты допустимы так же, как в json::Node::AsDouble
+        Value(static_cast<double>(value));
+    }
+}
+
+void BaseRequestDecoder::Value(double value) {
+    if (!extra_builder_ && depth_ == REQUEST_DEPTH && field_ == LATITUDE) {
+        request_.coordinates.lat = value;
+    }
+    else if (!extra_builder_ && depth_ == REQUEST_DEPTH && field_ == LONGITUDE) {
+        request_.coordinates.lng = value;
+    }
+    else {
+        AddExtra(value);
+    }
+}
+
+void BaseRequestDecoder::Value(string_view value) {
+    if (extra_builder_) {
+        AddExtra(value);
+    }
+    else if (depth_ == REQUEST_DEPTH && field_ == TYPE) {
+        request_.type = value == "Stop"sv ? BaseRequest::Type::STOP
+                      : value == "Bus"sv ? BaseRequest::Type::BUS : BaseRequest::Type::OTHER;
+    }
+    else if (depth_ == REQUEST_DEPTH && field_ == NAME) {
+        request_.name = value;
+    }
+    else if (depth_ == FIELD_DEPTH && field_ == STOPS) {
+        request_.stops.emplace_back(value);
+    }
+    else {
+        AddExtra(value);
+    }
+}
+
+BaseRequest BaseRequestDecoder::Extract() {
+    BaseRequest request = move(request_);
+    request_ = BaseRequest{};
+    field_ = UNKNOWN;
+    seen_ = 0;
+    is_complete_ = false;
+    return request;
+}
+
+void BaseRequestDecoder::ThrowUnexpected() const {
+    if (field_ == UNKNOWN) {
+        throw json::ParsingError("Base request must be a dictionary"s);
+    }
+    throw json::ParsingError("Unexpected value of base request field '"s + string(BASE_FIELD_NAMES[field_]) + "'"s);
+}
+
+void BaseRequestDecoder::CheckRequired() const {
+    uint32_t required = Bit(TYPE);
+    if (request_.type == BaseRequest::Type::STOP) {
+        required |= Bit(NAME) | Bit(LATITUDE) | Bit(LONGITUDE) | Bit(ROAD_DISTANCES);
+    }
+    else if (request_.type == BaseRequest::Type::BUS) {
+        required |= Bit(NAME) | Bit(STOPS) | Bit(IS_ROUNDTRIP);
+    }
+    for (size_t field = 0; field < FIELD_COUNT; ++field) {
+        if ((required & Bit(field)) && !(seen_ & Bit(field))) {
+            throw json::ParsingError("Base request has no field '"s + string(BASE_FIELD_NAMES[field]) + "'"s);
+        }
+    }
+}
+
+template <typename Scalar>
+void BaseRequestDecoder::AddExtra(Scalar value) {
+    if (extra_builder_) {
+        extra_builder_->Value(value);
+        return;
+    }
+    if (depth_ != REQUEST_DEPTH || field_ != UNKNOWN) {
+        ThrowUnexpected();
+    }
+    json::Node node;
+    if constexpr (is_same_v<Scalar, string_view>) {
+        node = json::Node(string(value));
+    }
+    else {
+        node = json::Node(value);
+    }
+    AddExtraNode(move(node));
+}
+
+void BaseRequestDecoder::FinishExtra() {
+    json::Node node = extra_builder_->Build();
+    extra_builder_.reset();
+    AddExtraNode(move(node));
+}
+
+void BaseRequestDecoder::AddExtraNode(json::Node node) {
+    if (const auto [it, inserted] = request_.extra.try_emplace(move(extra_key_), move(node)); !inserted) {
+        throw json::ParsingError("Duplicate key '"s + it->first + "' have been found"s);
+    }
+}
+
+StatType GetStatType(string_view type) {
+    const size_t index = STAT_TYPES.Find(type);
+    return index == STAT_TYPES.NOT_FOUND ? StatType::MAP : static_cast<StatType>(index);
+}
+
+} // namespace requests
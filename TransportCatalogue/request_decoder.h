@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "domain.h"
+#include "geo.h"
+#include "json.h"
+#include "json_sax.h"
+
+namespace requests {
+
+// Запрос из base_requests, разобранный по известной схеме без построения дерева Node
+struct BaseRequest {
+    enum class Type {
+        STOP,
+        BUS,
+        // Запрос другого типа; такие запросы пропускаются
+        OTHER,
+    };
+
+    Type type = Type::OTHER;
+    std::string name;
+    geo::Coordinates coordinates;
+    std::vector<TrC::detail::DistanceToStop> road_distances;
+    std::vector<std::string> stops;
+    bool is_roundtrip = false;
+    // Поля, не входящие в схему, в виде обычных узлов JSON
+    json::Dict extra;
+};
+
+// Разбирает один элемент base_requests из событий SAX, от StartDict запроса до его EndDict.
+// Ключи схемы распознаются по совершенному хэшу, построенному при компиляции, а значения
+// сразу записываются в поля BaseRequest. Значение неподходящего типа, повтор ключа или
+// отсутствие обязательного поля - ParsingError
+class BaseRequestDecoder final : public json::SaxHandler {
+public:
+    void StartDict() override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Key(std::string_view key) override;
+
+    void Value(std::nullptr_t value) override;
+    void Value(bool value) override;
+    void Value(int value) override;
+    void Value(double value) override;
+    void Value(std::string_view value) override;
+
+    // Закрыт ли словарь запроса
+    bool IsComplete() const {
+        return is_complete_;
+    }
+
+    // Возвращает разобранный запрос и готовит декодер к следующему
+    BaseRequest Extract();
+
+private:
+    // Поля схемы; порядок совпадает с порядком ключей в таблице совершенного хэша
+    enum Field : size_t {
+        TYPE,
+        NAME,
+        LATITUDE,
+        LONGITUDE,
+        ROAD_DISTANCES,
+        STOPS,
+        IS_ROUNDTRIP,
+        FIELD_COUNT,
+        UNKNOWN = FIELD_COUNT,
+    };
+
+    // Глубина вложенности: внутри словаря запроса и внутри road_distances или stops
+    static constexpr int REQUEST_DEPTH = 1;
+    static constexpr int FIELD_DEPTH = 2;
+
+    [[noreturn]] void ThrowUnexpected() const;
+    void CheckRequired() const;
+    // Значение поля, не входящего в схему
+    template <typename Scalar>
+    void AddExtra(Scalar value);
+    void FinishExtra();
+    void AddExtraNode(json::Node node);
+
+    BaseRequest request_;
+    int depth_ = 0;
+    Field field_ = UNKNOWN;
+    uint32_t seen_ = 0;
+    bool is_complete_ = false;
+    std::string extra_key_;
+    std::optional<json::NodeBuilder> extra_builder_;
+    int extra_depth_ = 0;
+    std::vector<std::string_view> distance_names_;
+};
+
+// Тип запроса из stat_requests
+enum class StatType {
+    STOP,
+    BUS,
+    ROUTE,
+    NEAREST_STOPS,
+    STOPS_IN_AREA,
+    SEARCH_NAMES,
+    BUS_POSITIONS,
+    // Запрос Map и запросы неизвестного типа: на них, как и раньше, возвращается карта
+    MAP,
+};
+
+StatType GetStatType(std::string_view type);
+
+} // namespace requests
@@ -1,6 +1,8 @@
 #include "request_handler.h"
 
+#include <algorithm>
 #include <map>
+#include <sstream>
 
 using namespace std;
 
@@ -13,6 +15,29 @@ optional<TrC::BusInfo> RequestHandler::GetBusInfo(const string_view& bus_name) c
     }
 }
 
+optional<vehicles::Position> RequestHandler::GetBusPosition(string_view bus_name) const {
+    const auto it = db_.GetBuses().find(bus_name);
+    if (!positions_ || it == db_.GetBuses().end()) {
+        return nullopt;
+    }
+    return positions_->Get(it - db_.GetBuses().begin());
+}
+
+vector<pair<string_view, vehicles::Position>> RequestHandler::GetBusPositionsInArea(geo::Coordinates min, 
+                                                                                  geo::Coordinates max) const {
+    vector<pair<string_view, vehicles::Position>> result;
+    if (!positions_) {
+        return result;
+    }
+    for (const auto& [id, position] : positions_->FindInArea(min, max)) {
+        result.emplace_back((db_.GetBuses().begin() + id)->first, position);
+    }
+    sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+    return result;
+}
+
 svg::Document RequestHandler::RenderMap() const {
     svg::Document doc;
     map<string_view, TrC::Bus*> routes;
@@ -43,3 +68,19 @@ svg::Document RequestHandler::RenderMap() const {
     
     return doc;
 }
+
+string RequestHandler::RenderMapText() const {
+    ostringstream out;
+    RenderMap().Render(out);
+    return out.str();
+}
+
+bool RequestHandler::Deserialize(const string& path, router::TransportRouter& router) {
+    string map;
+    if (!serialization::Deserialize(path, db_, renderer_.GetSettings(), map, router)) {
+        return false;
+    }
+    // Базы, созданные до появления карты, её не содержат
+    renderer_.SetMap(map.empty() ? RenderMapText() : move(map));
+    return true;
+}
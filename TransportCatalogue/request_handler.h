@@ -4,6 +4,7 @@
 #include "map_renderer.h"
 #include "transport_router.h"
 #include "serialization.h"
+#include "vehicle_positions.h"
 
 class RequestHandler {
 public:
@@ -21,11 +22,36 @@ public:
 
     std::optional<TrC::BusInfo> GetBusInfo(const std::string_view& bus_name) const;
 
-    const std::vector<std::string> GetBusesByStop(std::string_view stop_name) const {
-        std::vector<std::string_view> temp = db_.GetBusesForStop(stop_name);
-        return std::vector<std::string>(temp.begin(), temp.end());
+    TrC::BusesRange GetBusesByStop(std::string_view stop_name) const {
+        return db_.GetBusesForStop(stop_name);
     }
     
+    std::vector<std::pair<const TrC::Stop*, double>> GetNearestStops(geo::Coordinates coord, size_t count) const {
+        return db_.FindNearestStops(coord, count);
+    }
+    
+    std::vector<const TrC::Stop*> GetStopsInArea(geo::Coordinates min, geo::Coordinates max) const {
+        return db_.FindStopsInArea(min, max);
+    }
+    
+    std::vector<TrC::NameMatch> GetNamesByPrefix(std::string_view prefix, size_t limit) const {
+        return db_.FindNamesByPrefix(prefix, limit);
+    }
+    
+    std::vector<TrC::NameMatch> GetSimilarNames(std::string_view name, size_t limit) const {
+        return db_.FindSimilarNames(name, limit);
+    }
+    
+    // Таблица положений автобусов, заполняемая потоком vehicles::PositionFeed
+    void SetPositions(const vehicles::PositionTable* positions) {
+        positions_ = positions;
+    }
+    
+    std::optional<vehicles::Position> GetBusPosition(std::string_view bus_name) const;
+    
+    std::vector<std::pair<std::string_view, vehicles::Position>> GetBusPositionsInArea(geo::Coordinates min, 
+                                                                                     geo::Coordinates max) const;
+    
     bool StopCount(std::string_view name) const {
         return db_.StopCount(name);
     }
@@ -36,6 +62,17 @@ public:
     
     svg::Document RenderMap() const;
     
+    // Карта в формате SVG. Она зависит только от базы и настроек отрисовки, поэтому
+    // отрисовывается один раз при создании базы и хранится в ней
+    const std::string& GetMap() const {
+        return renderer_.GetMap();
+    }
+    
+    // Отрисовывает карту заново, например после изменения справочника
+    void UpdateMap() {
+        renderer_.SetMap(RenderMapText());
+    }
+    
     void GraphInit(router::RoutingSettings settings) {
         graph_ = std::move(router::GraphInit(settings, db_));
     }
@@ -49,15 +86,20 @@ public:
     }
     
     void Serialize(const std::string& path, router::RoutingSettings settings) {
-        serialization::Serialize(path, db_, renderer_.GetSettings(), MakeTransportRouterWithGraph(settings));
+        Serialize(path, MakeTransportRouterWithGraph(settings));
     }
     
-    bool Deserialize(const std::string& path, router::TransportRouter& router) {
-        return serialization::Deserialize(path, db_, renderer_.GetSettings(), router);           
+    void Serialize(const std::string& path, const router::TransportRouter& router) {
+        serialization::Serialize(path, db_, renderer_.GetSettings(), RenderMapText(), router);
     }
+    
+    bool Deserialize(const std::string& path, router::TransportRouter& router);
 
 private:
+    std::string RenderMapText() const;
+    
     TrC::TransportCatalogue& db_;
     renderer::MapRenderer& renderer_;
     router::Graph& graph_;
+    const vehicles::PositionTable* positions_ = nullptr;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "serialization.h"
 #include <fstream>
+#include <stdexcept>
 
 namespace serialization {
 
@@ -44,6 +45,94 @@ TrC::Bus LoadBus(const serialize::Bus& pb_bus, const TrC::TransportCatalogue& ca
     return {pb_bus.name(), route, pb_bus.is_ring()};
 }
     
+serialize::BusesForStops SaveBusesForStops(const TrC::TransportCatalogue& catalogue) {
+    serialize::BusesForStops pb_index;
+    
+    for (const auto offset : catalogue.GetBusesForStopsOffsets()) {
+        pb_index.add_offsets(offset);
+    }
+    for (const auto bus_name : catalogue.GetBusesForStops()) {
+        pb_index.add_bus_ids(catalogue.GetBuses().find(bus_name) - catalogue.GetBuses().begin());
+    }
+    
+    return pb_index;
+}
+    
+void LoadBusesForStops(const serialize::BusesForStops& pb_index, TrC::TransportCatalogue& catalogue) {
+    // Базы, созданные до появления индекса, его не содержат
+    if (pb_index.offsets_size() == 0) {
+        catalogue.BuildBusesForStopsIndex();
+        return;
+    }
+    catalogue.SetBusesForStopsIndex({pb_index.offsets().begin(), pb_index.offsets().end()}, 
+                                    {pb_index.bus_ids().begin(), pb_index.bus_ids().end()});
+}
+    
+serialize::SpatialIndex SaveSpatialIndex(const spatial::GridIndex& index) {
+    serialize::SpatialIndex pb_index;
+    
+    const spatial::GridParams& params = index.GetParams();
+    pb_index.set_min_lat(params.min_lat);
+    pb_index.set_min_lng(params.min_lng);
+    pb_index.set_cell_lat(params.cell_lat);
+    pb_index.set_cell_lng(params.cell_lng);
+    pb_index.set_rows(params.rows);
+    pb_index.set_cols(params.cols);
+    for (const auto offset : index.GetOffsets()) {
+        pb_index.add_offsets(offset);
+    }
+    for (const auto id : index.GetIds()) {
+        pb_index.add_stop_ids(id);
+    }
+    
+    return pb_index;
+}
+    
+void LoadSpatialIndex(const serialize::SpatialIndex& pb_index, TrC::TransportCatalogue& catalogue) {
+    // Базы, созданные до появления индекса, его не содержат
+    if (pb_index.offsets_size() == 0) {
+        catalogue.BuildSpatialIndex();
+        return;
+    }
+    spatial::GridParams params{pb_index.min_lat(), pb_index.min_lng(), pb_index.cell_lat(),
+                               pb_index.cell_lng(), pb_index.rows(), pb_index.cols()};
+    catalogue.SetSpatialIndex(params, {pb_index.offsets().begin(), pb_index.offsets().end()}, 
+                              {pb_index.stop_ids().begin(), pb_index.stop_ids().end()});
+}
+    
+serialize::NameIndex SaveNameIndex(const search::NameIndex& index) {
+    serialize::NameIndex pb_index;
+    
+    for (const auto offset : index.GetChildOffsets()) {
+        pb_index.add_child_offsets(offset);
+    }
+    pb_index.set_labels(index.GetLabels());
+    for (const auto target : index.GetTargets()) {
+        pb_index.add_targets(target);
+    }
+    for (const auto offset : index.GetValueOffsets()) {
+        pb_index.add_value_offsets(offset);
+    }
+    for (const auto value : index.GetValues()) {
+        pb_index.add_values(value);
+    }
+    
+    return pb_index;
+}
+    
+void LoadNameIndex(const serialize::NameIndex& pb_index, TrC::TransportCatalogue& catalogue) {
+    // Базы, созданные до появления индекса, его не содержат
+    if (pb_index.child_offsets_size() == 0) {
+        catalogue.BuildNameIndex();
+        return;
+    }
+    catalogue.SetNameIndex(search::NameIndex({pb_index.child_offsets().begin(), pb_index.child_offsets().end()},
+                                             pb_index.labels(),
+                                             {pb_index.targets().begin(), pb_index.targets().end()},
+                                             {pb_index.value_offsets().begin(), pb_index.value_offsets().end()},
+                                             {pb_index.values().begin(), pb_index.values().end()}));
+}
+    
 serialize::Rgb SaveRgb(const svg::Rgb& rgb) {
     serialize::Rgb pb_rgb;
     
@@ -365,7 +454,7 @@ void LoadTransportRouter(const serialize::TransportRouter& pb_router, router::Tr
 }
     
 serialize::TransportCatalogue SaveTransportCatalogue(const TrC::TransportCatalogue& catalogue,
-              const renderer::RenderSettings& settings, const router::TransportRouter& router) {
+              const renderer::RenderSettings& settings, const string& map, const router::TransportRouter& router) {
     serialize::TransportCatalogue pb_catalogue;
     int i = 0;
     for (auto it = catalogue.StopsBegin(); it != catalogue.StopsEnd(); ++it) {
@@ -390,7 +479,11 @@ serialize::TransportCatalogue SaveTransportCatalogue(const TrC::TransportCatalog
         *pb_catalogue.add_distances() = pb_distance;
     }
     
+    *pb_catalogue.mutable_buses_for_stops() = SaveBusesForStops(catalogue);
+    *pb_catalogue.mutable_spatial_index() = SaveSpatialIndex(catalogue.GetSpatialIndex());
+    *pb_catalogue.mutable_name_index() = SaveNameIndex(catalogue.GetNameIndex());
     *pb_catalogue.mutable_render_settings() = move(SaveRenderSettings(settings));
+    pb_catalogue.set_map(map);
     *pb_catalogue.mutable_router() = move(SaveTransportRouter(router, catalogue));
     
     return pb_catalogue;
@@ -403,10 +496,6 @@ void LoadTransportCatalogue(const serialize::TransportCatalogue& pb_catalogue,
         catalogue.AddStop(LoadStop(pb_catalogue.stops(i)));
     }
     
-    for (size_t i = 0; i < pb_catalogue.buses_size(); ++i) {
-        catalogue.AddBus(LoadBus(pb_catalogue.buses(i), catalogue));
-    }
-    
     for (size_t i = 0; i < pb_catalogue.distances_size(); ++i) {
         serialize::Distance pb_distance = pb_catalogue.distances(i);
         TrC::Stop* from_ptr = next(catalogue.GetStops().begin(), pb_distance.from_id())->second;
@@ -414,27 +503,40 @@ void LoadTransportCatalogue(const serialize::TransportCatalogue& pb_catalogue,
         
         catalogue.AddDistances(from_ptr, to_ptr, pb_distance.distance());
     }
+    
+    for (size_t i = 0; i < pb_catalogue.buses_size(); ++i) {
+        catalogue.AddBus(LoadBus(pb_catalogue.buses(i), catalogue));
+    }
+    
+    LoadBusesForStops(pb_catalogue.buses_for_stops(), catalogue);
+    LoadSpatialIndex(pb_catalogue.spatial_index(), catalogue);
+    LoadNameIndex(pb_catalogue.name_index(), catalogue);
 }
     
 void Serialize(const string& path, const TrC::TransportCatalogue& catalogue, 
-               const renderer::RenderSettings& settings, const router::TransportRouter& router) {
+               const renderer::RenderSettings& settings, const string& map, const router::TransportRouter& router) {
     ofstream out(path, ios::binary);
-    serialize::TransportCatalogue pb_catalogue = move(SaveTransportCatalogue(catalogue, settings, router));
+    serialize::TransportCatalogue pb_catalogue = move(SaveTransportCatalogue(catalogue, settings, map, router));
     pb_catalogue.SerializeToOstream(&out);
 }
     
 bool Deserialize(const string& path, TrC::TransportCatalogue& catalogue, renderer::RenderSettings& settings, 
-                                                    router::TransportRouter& router) {
+                 string& map, router::TransportRouter& router) {
     ifstream in_file(path, ios::binary);
     serialize::TransportCatalogue pb_catalogue;
     if (!pb_catalogue.ParseFromIstream(&in_file)) {
         return false;
     }
     
-    LoadTransportCatalogue(pb_catalogue, catalogue);
-    settings = LoadRenderSettings(pb_catalogue.render_settings());
-    LoadTransportRouter(pb_catalogue.router(), router, catalogue);
-    
+    try {
+        LoadTransportCatalogue(pb_catalogue, catalogue);
+        settings = LoadRenderSettings(pb_catalogue.render_settings());
+        map = move(*pb_catalogue.mutable_map());
+        LoadTransportRouter(pb_catalogue.router(), router, catalogue);
+    } catch (const invalid_argument&) {
+        // Индексы в файле не согласованы между собой: база повреждена
+        return false;
+    }
     return true;
 }
     
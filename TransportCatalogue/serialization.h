@@ -16,6 +16,15 @@ TrC::Stop LoadStop(const serialize::Stop& pb_stop);
 serialize::Bus SaveBus(const TrC::Bus& bus, int id, const TrC::TransportCatalogue& catalogue);
 TrC::Bus LoadBus(const serialize::Bus& pb_bus, const TrC::TransportCatalogue& catalogue);
     
+serialize::BusesForStops SaveBusesForStops(const TrC::TransportCatalogue& catalogue);
+void LoadBusesForStops(const serialize::BusesForStops& pb_index, TrC::TransportCatalogue& catalogue);
+    
+serialize::SpatialIndex SaveSpatialIndex(const spatial::GridIndex& index);
+void LoadSpatialIndex(const serialize::SpatialIndex& pb_index, TrC::TransportCatalogue& catalogue);
+    
+serialize::NameIndex SaveNameIndex(const search::NameIndex& index);
+void LoadNameIndex(const serialize::NameIndex& pb_index, TrC::TransportCatalogue& catalogue);
+    
 serialize::Rgb SaveRgb(const svg::Rgb& rgb);
 svg::Rgb LoadRgb(const serialize::Rgb& pb_rgb);
     
@@ -75,13 +84,17 @@ void LoadTransportRouter(const serialize::TransportRouter& pb_router, router::Tr
                                             const TrC::TransportCatalogue& catalogue);
     
 serialize::TransportCatalogue SaveTransportCatalogue(const TrC::TransportCatalogue& catalogue,
-                    const renderer::RenderSettings& settings, const router::TransportRouter& router);
+                    const renderer::RenderSettings& settings, const std::string& map,
+                    const router::TransportRouter& router);
 void LoadTransportCatalogue(const serialize::TransportCatalogue& pb_catalogue, 
                                               TrC::TransportCatalogue& catalogue);
     
 void Serialize(const std::string& path, const TrC::TransportCatalogue& catalogue,
-              const renderer::RenderSettings& settings, const router::TransportRouter& router);
+              const renderer::RenderSettings& settings, const std::string& map,
+              const router::TransportRouter& router);
+// map - отрисованная карта; пустая, если база создана до того, как карта стала в ней храниться
+// Возвращает false, если файл не разобран или его индексы не согласованы
 bool Deserialize(const std::string& path, TrC::TransportCatalogue& catalogue,
-                renderer::RenderSettings& settings, router::TransportRouter& router);
+                renderer::RenderSettings& settings, std::string& map, router::TransportRouter& router);
     
 } // namespace serialization
\ No newline at end of file
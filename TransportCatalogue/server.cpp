@@ -0,0 +1,616 @@
+#include "server.h"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace server {
+
+using namespace std;
+
+namespace {
+
+// Номера событий epoll; соединения нумеруются начиная с FIRST_CONNECTION_ID
+const uint64_t LISTEN_ID = 0;
+const uint64_t WAKE_ID = 1;
+const uint64_t SIGNAL_ID = 2;
+const uint64_t FIRST_CONNECTION_ID = 3;
+
+const int MAX_EVENTS = 64;
+const size_t READ_BUFFER_SIZE = 1 << 16;
+// Соединение со строкой длиннее этого закрывается
+const size_t MAX_LINE_SIZE = 1 << 24;
+// Пока у соединения столько запросов без ответа или столько невыведенных байтов ответов,
+// новые запросы из него не читаются: память сервера не зависит от скорости клиента
+const uint64_t MAX_PIPELINE = 256;
+const size_t MAX_OUTPUT_SIZE = 1 << 22;
+// Если приём соединений приостановлен из-за нехватки дескрипторов, а ни одно соединение
+// не закрылось, он возобновляется через столько миллисекунд
+const int ACCEPT_RETRY_INTERVAL_MS = 100;
+// Процесс, проработавший меньше этого, перезапускается с такой задержкой: ошибка при запуске
+// не превращается в непрерывный перезапуск
+const auto MIN_PROCESS_LIFETIME = chrono::seconds(1);
+
+[[noreturn]] void ThrowSystemError(const string& what) {
+    throw runtime_error(what + ": "s + strerror(errno));
+}
+
+// Сигналы остановки и SIGHUP - сигнал перезагрузки базы
+sigset_t ServerSignals() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    return signals;
+}
+
+int Listen(const Address& address) {
+    int fd = -1;
+    if (!address.socket_path.empty()) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (address.socket_path.size() >= sizeof(addr.sun_path)) {
+            throw runtime_error("Socket path is too long: "s + address.socket_path);
+        }
+        memcpy(addr.sun_path, address.socket_path.data(), address.socket_path.size());
+        // Сокет, оставшийся от прошлого запуска, заменяется; другие файлы не трогаются
+        if (struct stat info; stat(address.socket_path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+            unlink(address.socket_path.c_str());
+        }
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            ThrowSystemError("Failed to create socket"s);
+        }
+        if (bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            ThrowSystemError("Failed to bind "s + address.socket_path);
+        }
+    } else {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(address.port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            ThrowSystemError("Failed to create socket"s);
+        }
+        const int enable = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        if (bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close(fd);
+            ThrowSystemError("Failed to bind port "s + to_string(address.port));
+        }
+    }
+    if (listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        ThrowSystemError("Failed to listen"s);
+    }
+    return fd;
+}
+
+pid_t StartProcess(const function<int()>& serve, const sigset_t& mask) {
+    const pid_t pid = fork();
+    if (pid < 0) {
+        ThrowSystemError("Failed to start worker process"s);
+    }
+    if (pid > 0) {
+        return pid;
+    }
+    pthread_sigmask(SIG_SETMASK, &mask, nullptr);
+    int code = 1;
+    try {
+        code = serve();
+    } catch (const exception& error) {
+        cerr << error.what() << endl;
+    }
+    // Объекты родителя не разрушаются: освобождение базы изменило бы общие страницы памяти
+    cout.flush();
+    _exit(code);
+}
+
+void AddEvents(int epoll_fd, int fd, uint64_t id, uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = id;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        ThrowSystemError("Failed to watch descriptor"s);
+    }
+}
+
+} // namespace
+
+void BlockSignals() {
+    const sigset_t signals = ServerSignals();
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+}
+
+Listener::Listener(const Address& address) : fd_(Listen(address)), owner_pid_(getpid()) {
+    if (!address.socket_path.empty()) {
+        socket_path_ = address.socket_path;
+    }
+}
+
+Listener::~Listener() {
+    close(fd_);
+    if (!socket_path_.empty() && getpid() == owner_pid_) {
+        unlink(socket_path_.c_str());
+    }
+}
+
+bool Server::Connection::CanQueue() const {
+    return next_request - next_response < MAX_PIPELINE && output.size() < MAX_OUTPUT_SIZE;
+}
+
+Server::Server(const Listener& listener, Answer answer, size_t workers, function<void()> reload)
+    : answer_(move(answer)), reload_(move(reload)), listen_fd_(listener.GetFd()) {
+    // Сигналы остановки принимаются циклом событий через signalfd. Маска задаётся до запуска
+    // потоков пула, чтобы они её унаследовали; потоки, запущенные раньше сервера, должны
+    // получить её от BlockSignals
+    const sigset_t signals = ServerSignals();
+    BlockSignals();
+    // Клиент может закрыть соединение раньше, чем получит ответы
+    signal(SIGPIPE, SIG_IGN);
+
+    try {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        signal_fd_ = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (epoll_fd_ < 0 || wake_fd_ < 0 || signal_fd_ < 0) {
+            ThrowSystemError("Failed to create event loop"s);
+        }
+        // Если сокет слушают несколько процессов, о новом соединении узнаёт один из них
+        AddEvents(epoll_fd_, listen_fd_, LISTEN_ID, EPOLLIN | EPOLLEXCLUSIVE);
+        AddEvents(epoll_fd_, wake_fd_, WAKE_ID, EPOLLIN);
+        AddEvents(epoll_fd_, signal_fd_, SIGNAL_ID, EPOLLIN);
+    } catch (...) {
+        Release();
+        throw;
+    }
+    next_id_ = FIRST_CONNECTION_ID;
+
+    workers_.reserve(max<size_t>(workers, 1));
+    for (size_t i = 0; i < max<size_t>(workers, 1); ++i) {
+        workers_.emplace_back([this] { Work(); });
+    }
+}
+
+Server::~Server() {
+    Stop();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    // Отложенные ответы обращаются к серверу, поэтому дожидаемся их
+    {
+        unique_lock lock(mutex_);
+        answered_.wait(lock, [this] {
+            return unanswered_ == 0;
+        });
+    }
+    for (auto& [id, connection] : connections_) {
+        close(connection.fd);
+    }
+    connections_.clear();
+    Release();
+}
+
+void Server::Release() {
+    for (int* fd : {&epoll_fd_, &wake_fd_, &signal_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    const sigset_t signals = ServerSignals();
+    pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+}
+
+void Server::Run() {
+    epoll_event events[MAX_EVENTS];
+    while (true) {
+        const int count = epoll_wait(epoll_fd_, events, MAX_EVENTS,
+                                     accept_paused_ ? ACCEPT_RETRY_INTERVAL_MS : -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ThrowSystemError("Failed to wait for events"s);
+        }
+        if (count == 0) {
+            ResumeAccept();
+        }
+        for (int i = 0; i < count; ++i) {
+            const uint64_t id = events[i].data.u64;
+            if (id == LISTEN_ID) {
+                Accept();
+            } else if (id == WAKE_ID) {
+                Complete();
+                lock_guard lock(mutex_);
+                if (stop_) {
+                    return;
+                }
+            } else if (id == SIGNAL_ID) {
+                signalfd_siginfo info;
+                if (read(signal_fd_, &info, sizeof(info)) != static_cast<ssize_t>(sizeof(info))) {
+                    continue;
+                }
+                if (info.ssi_signo != SIGHUP) {
+                    Stop();
+                    return;
+                }
+                if (reload_) {
+                    reload_();
+                } else {
+                    cerr << "Base reload is not supported in this mode"sv << endl;
+                }
+            } else if (const auto it = connections_.find(id); it != connections_.end()) {
+                Connection& connection = it->second;
+                // Ответ клиенту, закрывшему соединение в обе стороны, доставить уже нельзя
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    Close(id);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) {
+                    Read(id, connection);
+                }
+                if (events[i].events & EPOLLOUT) {
+                    Write(connection);
+                }
+                Update(id, connection);
+            }
+        }
+    }
+}
+
+void Server::Stop() {
+    {
+        lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    has_jobs_.notify_all();
+    Wake();
+}
+
+void Server::Work() {
+    unique_lock lock(mutex_);
+    while (true) {
+        has_jobs_.wait(lock, [this] {
+            return stop_ || !jobs_.empty();
+        });
+        if (stop_) {
+            return;
+        }
+        Job job = move(jobs_.front());
+        jobs_.pop_front();
+        ++unanswered_;
+        lock.unlock();
+        answer_(job.line, [this, connection = job.connection, request = job.request](string response) {
+            Deliver(connection, request, move(response));
+        });
+        lock.lock();
+    }
+}
+
+void Server::Deliver(uint64_t connection, uint64_t request, string response) {
+    lock_guard lock(mutex_);
+    // Цикл событий будится один раз на пачку готовых ответов
+    if (done_.empty()) {
+        Wake();
+    }
+    done_.push_back({connection, request, move(response)});
+    // Под блокировкой: иначе деструктор, дождавшись последнего ответа, мог бы удалить answered_
+    // раньше, чем закончится notify
+    --unanswered_;
+    answered_.notify_all();
+}
+
+void Server::Accept() {
+    while (true) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            // Соединение остаётся в очереди, и слушающий сокет сразу сообщил бы о нём снова.
+            // При нехватке дескрипторов или памяти приём приостанавливается, пока не закроется
+            // соединение или не пройдёт ACCEPT_RETRY_INTERVAL
+            if (!accept_failing_) {
+                cerr << "Failed to accept connection: "sv << strerror(errno) << endl;
+                accept_failing_ = true;
+            }
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                PauseAccept();
+            }
+            return;
+        }
+        accept_failing_ = false;
+        // Ответы короткие и отправляются сразу, без ожидания следующих
+        const int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        const uint64_t id = next_id_++;
+        Connection& connection = connections_[id];
+        connection.fd = fd;
+        connection.events = EPOLLIN;
+        AddEvents(epoll_fd_, fd, id, connection.events);
+    }
+}
+
+void Server::PauseAccept() {
+    if (!accept_paused_ && epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, listen_fd_, nullptr) == 0) {
+        accept_paused_ = true;
+    }
+}
+
+void Server::ResumeAccept() {
+    if (!accept_paused_) {
+        return;
+    }
+    // Событие с EPOLLEXCLUSIVE нельзя изменить, только удалить и добавить заново
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.u64 = LISTEN_ID;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) == 0) {
+        accept_paused_ = false;
+    }
+}
+
+void Server::Read(uint64_t id, Connection& connection) {
+    char buffer[READ_BUFFER_SIZE];
+    // Из сокета читается, только пока соединению можно ставить запросы в очередь: остальное ждёт
+    // в сокете, и клиент, отправляющий запросы быстрее, чем получает ответы, не занимает память сервера
+    while (connection.CanQueue()) {
+        const ssize_t size = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (size > 0) {
+            connection.input.append(buffer, static_cast<size_t>(size));
+            Split(id, connection);
+            if (static_cast<size_t>(size) < sizeof(buffer)) {
+                break;
+            }
+        } else if (size == 0) {
+            connection.read_closed = true;
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                connection.failed = true;
+                return;
+            }
+            break;
+        }
+    }
+
+    Split(id, connection);
+}
+
+void Server::Split(uint64_t id, Connection& connection) {
+    vector<Job> jobs;
+    size_t begin = 0;
+    for (size_t end; connection.CanQueue() && (end = connection.input.find('\n', begin)) != string::npos; begin = end + 1) {
+        string_view line(connection.input.data() + begin, end - begin);
+        if (line.find_first_not_of(" \t\r"sv) != string_view::npos) {
+            jobs.push_back({id, connection.next_request++, string(line)});
+        }
+    }
+    connection.input.erase(0, begin);
+    const bool has_line = connection.input.find('\n') != string::npos;
+    // Последняя строка может быть без перевода строки
+    if (connection.read_closed && !has_line && connection.CanQueue()) {
+        if (connection.input.find_first_not_of(" \t\r"sv) != string::npos) {
+            jobs.push_back({id, connection.next_request++, move(connection.input)});
+        }
+        connection.input.clear();
+    } else if (!connection.read_closed && !has_line && connection.input.size() > MAX_LINE_SIZE) {
+        connection.read_closed = true;
+        connection.input.clear();
+    }
+
+    if (!jobs.empty()) {
+        {
+            lock_guard lock(mutex_);
+            move(jobs.begin(), jobs.end(), back_inserter(jobs_));
+        }
+        if (jobs.size() == 1) {
+            has_jobs_.notify_one();
+        } else {
+            has_jobs_.notify_all();
+        }
+    }
+}
+
+void Server::Write(Connection& connection) {
+    size_t sent = 0;
+    while (sent < connection.output.size()) {
+        const ssize_t size = send(connection.fd, connection.output.data() + sent,
+                                  connection.output.size() - sent, MSG_NOSIGNAL);
+        if (size >= 0) {
+            sent += static_cast<size_t>(size);
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // Клиент больше не принимает ответы
+                connection.failed = true;
+                return;
+            }
+            break;
+        }
+    }
+    connection.output.erase(0, sent);
+}
+
+void Server::Complete() {
+    uint64_t counter;
+    while (read(wake_fd_, &counter, sizeof(counter)) < 0 && errno == EINTR) {
+    }
+    vector<Done> done;
+    {
+        lock_guard lock(mutex_);
+        done.swap(done_);
+    }
+    for (auto& [id, request, response] : done) {
+        const auto it = connections_.find(id);
+        if (it == connections_.end()) {
+            continue;
+        }
+        Connection& connection = it->second;
+        if (request != connection.next_response) {
+            connection.ready.emplace(request, move(response));
+            continue;
+        }
+        connection.output += response;
+        connection.output += '\n';
+        ++connection.next_response;
+        for (auto next = connection.ready.begin();
+             next != connection.ready.end() && next->first == connection.next_response;
+             next = connection.ready.erase(next)) {
+            connection.output += next->second;
+            connection.output += '\n';
+            ++connection.next_response;
+        }
+    }
+    // Ответы отправляются сразу; то, что не поместилось в сокет, дождётся EPOLLOUT
+    for (const auto& [id, request, response] : done) {
+        if (const auto it = connections_.find(id); it != connections_.end()) {
+            // Строки, прочитанные сверх MAX_PIPELINE, ставятся в очередь по мере ответов
+            Split(id, it->second);
+            if (!it->second.output.empty()) {
+                Write(it->second);
+            }
+            Update(id, it->second);
+        }
+    }
+}
+
+void Server::Update(uint64_t id, Connection& connection) {
+    const uint64_t pending = connection.next_request - connection.next_response;
+    if (connection.failed || (connection.read_closed && pending == 0 && connection.output.empty())) {
+        Close(id);
+        return;
+    }
+    uint32_t events = 0;
+    if (!connection.read_closed && connection.CanQueue()) {
+        events |= EPOLLIN;
+    }
+    if (!connection.output.empty()) {
+        events |= EPOLLOUT;
+    }
+    if (events != connection.events) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = id;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+        connection.events = events;
+    }
+}
+
+void Server::Close(uint64_t id) {
+    const auto it = connections_.find(id);
+    if (it == connections_.end()) {
+        return;
+    }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    connections_.erase(it);
+    // Освободился дескриптор, которого могло не хватить для нового соединения
+    ResumeAccept();
+}
+
+void Server::Wake() {
+    const uint64_t one = 1;
+    // Переполнение счётчика невозможно на практике, а EAGAIN означает, что цикл уже разбужен
+    [[maybe_unused]] const ssize_t result = write(wake_fd_, &one, sizeof(one));
+}
+
+void RunProcesses(size_t processes, const function<int()>& serve) {
+    sigset_t signals = ServerSignals();
+    sigaddset(&signals, SIGCHLD);
+    sigset_t mask;
+    pthread_sigmask(SIG_BLOCK, &signals, &mask);
+    const int signal_fd = signalfd(-1, &signals, SFD_CLOEXEC);
+    if (signal_fd < 0) {
+        pthread_sigmask(SIG_SETMASK, &mask, nullptr);
+        ThrowSystemError("Failed to watch signals"s);
+    }
+
+    // Освобождённые при загрузке базы блоки malloc объединяются заранее. Иначе это сделает первое
+    // же крупное освобождение в каждом процессе, изменив страницы по всей куче, и они перестанут
+    // быть общими
+    malloc_trim(0);
+
+    unordered_map<pid_t, chrono::steady_clock::time_point> children;
+    const auto start = [&] {
+        children.emplace(StartProcess(serve, mask), chrono::steady_clock::now());
+    };
+    for (size_t i = 0; i < processes; ++i) {
+        start();
+    }
+    bool stopping = false;
+    while (!children.empty()) {
+        signalfd_siginfo info;
+        if (read(signal_fd, &info, sizeof(info)) != static_cast<ssize_t>(sizeof(info))) {
+            continue;
+        }
+        if (info.ssi_signo == SIGHUP) {
+            cerr << "Base reload is not supported with worker processes"sv << endl;
+            continue;
+        }
+        if (info.ssi_signo != SIGCHLD) {
+            stopping = true;
+            for (const auto& [pid, started] : children) {
+                kill(pid, SIGTERM);
+            }
+            continue;
+        }
+        // Несколько SIGCHLD могут прийти одним сигналом, поэтому собираются все завершившиеся процессы
+        int status = 0;
+        for (pid_t pid; (pid = waitpid(-1, &status, WNOHANG)) > 0;) {
+            const auto it = children.find(pid);
+            if (it == children.end()) {
+                continue;
+            }
+            const auto lifetime = chrono::steady_clock::now() - it->second;
+            children.erase(it);
+            if (stopping) {
+                continue;
+            }
+            cerr << "Worker process "sv << pid;
+            if (WIFSIGNALED(status)) {
+                cerr << " killed by signal "sv << WTERMSIG(status);
+            } else {
+                cerr << " exited with code "sv << WEXITSTATUS(status);
+            }
+            cerr << ", restarting"sv << endl;
+            if (lifetime < MIN_PROCESS_LIFETIME) {
+                this_thread::sleep_for(MIN_PROCESS_LIFETIME);
+            }
+            start();
+        }
+    }
+    close(signal_fd);
+    pthread_sigmask(SIG_SETMASK, &mask, nullptr);
+}
+
+} // namespace server
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace server {
+
+// Адрес, на котором принимаются соединения: путь Unix-сокета или порт TCP на 127.0.0.1
+struct Address {
+    std::string socket_path;
+    uint16_t port = 0;
+};
+
+// Слушающий сокет. Его можно передать нескольким серверам, в том числе в дочерних процессах
+class Listener {
+public:
+    // Бросает std::runtime_error, если address не удалось открыть
+    explicit Listener(const Address& address);
+    Listener(const Listener&) = delete;
+    Listener& operator=(const Listener&) = delete;
+    // Файл Unix-сокета удаляет только создавший его процесс
+    ~Listener();
+
+    int GetFd() const {
+        return fd_;
+    }
+
+private:
+    int fd_ = -1;
+    std::string socket_path_;
+    int owner_pid_ = 0;
+};
+
+// Передаёт серверу ответ на запрос - JSON в одну строку, без перевода строки. Вызывается
+// ровно один раз из любого потока
+using Respond = std::function<void(std::string response)>;
+
+// Отвечает на одну строку запроса, вызывая respond. Ответ можно передать и после возврата,
+// например из фонового потока, не занимая поток пула. Вызывается одновременно из нескольких
+// потоков и не должен бросать исключений
+using Answer = std::function<void(std::string_view line, Respond respond)>;
+
+// Сервер построчных запросов: каждая непустая строка соединения - запрос, ответ на неё - строка.
+// Соединения обслуживает цикл событий epoll в потоке Run, запросы вычисляют потоки пула.
+// Соединение остаётся открытым между запросами, клиент может отправлять следующие запросы,
+// не дожидаясь ответов: ответы возвращаются в порядке запросов этого соединения
+class Server {
+public:
+    // Принимает соединения из listener, который должен пережить сервер; бросает
+    // std::runtime_error, если не удалось создать цикл событий. reload вызывается
+    // в потоке Run по сигналу SIGHUP и должен возвращать управление быстро; без него
+    // SIGHUP только записывается в stderr. Сигналы должны быть заблокированы BlockSignals
+    // во всех потоках процесса, запущенных до сервера. Деструктор дожидается всех ответов
+    Server(const Listener& listener, Answer answer, size_t workers, std::function<void()> reload = {});
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+    ~Server();
+
+    // Обслуживает соединения до вызова Stop или сигнала SIGINT или SIGTERM
+    void Run();
+
+    // Может вызываться из любого потока
+    void Stop();
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::string input;
+        std::string output;
+        // Номер следующего запроса и номер запроса, ответ на который выводится следующим
+        uint64_t next_request = 0;
+        uint64_t next_response = 0;
+        // Ответы, вычисленные раньше ответов на предыдущие запросы
+        std::map<uint64_t, std::string> ready;
+        bool read_closed = false;
+        // Ошибка сокета: соединение закрывается, не дожидаясь ответов
+        bool failed = false;
+        uint32_t events = 0;
+
+        // Можно ли читать и ставить в очередь следующие запросы: не превышены ли пределы
+        // запросов без ответа и невыведенных ответов
+        bool CanQueue() const;
+    };
+
+    struct Job {
+        uint64_t connection;
+        uint64_t request;
+        std::string line;
+    };
+
+    struct Done {
+        uint64_t connection;
+        uint64_t request;
+        std::string response;
+    };
+
+    void Work();
+    void Deliver(uint64_t connection, uint64_t request, std::string response);
+    void Accept();
+    void Read(uint64_t id, Connection& connection);
+    // Ставит в очередь запросы из полных строк input, пока это разрешает CanQueue; остальные
+    // строки остаются в input до ответов на предыдущие
+    void Split(uint64_t id, Connection& connection);
+    void Write(Connection& connection);
+    void Complete();
+    // Обновляет ожидаемые события соединения; закрывает его, если делать с ним больше нечего
+    void Update(uint64_t id, Connection& connection);
+    void Close(uint64_t id);
+    // Перестаёт ждать новых соединений и начинает снова
+    void PauseAccept();
+    void ResumeAccept();
+    void Wake();
+    // Закрывает дескрипторы цикла событий и возвращает маску сигналов
+    void Release();
+
+    Answer answer_;
+    std::function<void()> reload_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    int signal_fd_ = -1;
+    uint64_t next_id_ = 0;
+    bool accept_paused_ = false;
+    // Ошибка приёма соединения уже записана в stderr и не повторяется до успешного приёма
+    bool accept_failing_ = false;
+    std::unordered_map<uint64_t, Connection> connections_;
+
+    std::mutex mutex_;
+    std::condition_variable has_jobs_;
+    std::deque<Job> jobs_;
+    std::vector<Done> done_;
+    // Запросы, взятые потоками пула, на которые ещё не ответили
+    size_t unanswered_ = 0;
+    std::condition_variable answered_;
+    bool stop_ = false;
+    std::vector<std::thread> workers_;
+};
+
+// Блокирует в вызывающем потоке сигналы, которые сервер принимает через signalfd: SIGINT, SIGTERM
+// и SIGHUP. Потоки наследуют маску при создании, поэтому функция вызывается до запуска любых потоков
+// процесса сервера: иначе сигнал будет доставлен потоку, который его не ждёт, и завершит процесс
+void BlockSignals();
+
+// Запускает processes дочерних процессов, каждый из которых выполняет serve и завершается
+// с его кодом. Процессы создаются вызывающим процессом, поэтому получают его память - например,
+// загруженную базу - без копирования: страницы общие, пока их никто не изменяет. Упавший
+// процесс перезапускается. SIGHUP игнорируется, SIGINT и SIGTERM пересылаются дочерним процессам; функция
+// возвращает управление, когда все они завершатся. Других потоков у вызывающего процесса
+// быть не должно: в дочерние процессы они не переходят
+void RunProcesses(size_t processes, const std::function<int()>& serve);
+
+} // namespace server
@@ -0,0 +1,211 @@
+#define _USE_MATH_DEFINES
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+
+namespace spatial {
+
+using namespace std;
+
+namespace {
+
+const double DR = M_PI / 180.;
+// Среднее число точек в ячейке, на которое рассчитывается сетка
+const double POINTS_PER_CELL = 2.;
+const uint32_t MAX_SIDE = 4096;
+
+double MinCosLat(double min_lat, double max_lat) {
+    return cos(max(abs(min_lat), abs(max_lat)) * DR);
+}
+
+} // namespace
+
+GridIndex::GridIndex(const vector<geo::Coordinates>& points) {
+    if (points.empty()) {
+        return;
+    }
+
+    const auto [bottom_it, top_it] = minmax_element(points.begin(), points.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.lat < rhs.lat; });
+    const auto [left_it, right_it] = minmax_element(points.begin(), points.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.lng < rhs.lng; });
+
+    const double height = max(top_it->lat - bottom_it->lat, 1e-9);
+    const double width = max(right_it->lng - left_it->lng, 1e-9);
+    min_cos_lat_ = MinCosLat(bottom_it->lat, top_it->lat);
+
+    // Ячейки должны быть близки к квадратным в метрах, а не в градусах
+    const double cells = max(1., points.size() / POINTS_PER_CELL);
+    const double aspect = width * cos((bottom_it->lat + top_it->lat) / 2 * DR) / height;
+    params_.cols = static_cast<uint32_t>(clamp(round(sqrt(cells * aspect)), 1., double(MAX_SIDE)));
+    params_.rows = static_cast<uint32_t>(clamp(ceil(cells / params_.cols), 1., double(MAX_SIDE)));
+    params_.min_lat = bottom_it->lat;
+    params_.min_lng = left_it->lng;
+    params_.cell_lat = height / params_.rows;
+    params_.cell_lng = width / params_.cols;
+
+    vector<uint32_t> cell_of(points.size());
+    offsets_.assign(size_t(params_.rows) * params_.cols + 1, 0);
+    for (size_t i = 0; i < points.size(); ++i) {
+        cell_of[i] = Row(points[i].lat) * params_.cols + Col(points[i].lng);
+        ++offsets_[cell_of[i] + 1];
+    }
+    partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+    vector<uint32_t> fill(offsets_.begin(), offsets_.end() - 1);
+    ids_.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        ids_[fill[cell_of[i]]++] = static_cast<uint32_t>(i);
+    }
+    points_.Reserve(ids_.size());
+    for (const uint32_t id : ids_) {
+        points_.Add(points[id]);
+    }
+}
+
+GridIndex::GridIndex(GridParams params, vector<uint32_t> offsets, vector<uint32_t> ids,
+                     const vector<geo::Coordinates>& points)
+    : params_(params), offsets_(move(offsets)), ids_(move(ids)) {
+    if (offsets_.size() != size_t(params_.rows) * params_.cols + 1 || offsets_.back() != ids_.size()) {
+        throw invalid_argument("Spatial index does not match its parameters");
+    }
+    points_.Reserve(ids_.size());
+    for (const uint32_t id : ids_) {
+        points_.Add(points.at(id));
+    }
+    min_cos_lat_ = MinCosLat(params_.min_lat, params_.min_lat + params_.cell_lat * params_.rows);
+}
+
+uint32_t GridIndex::Row(double lat) const {
+    const double row = floor((lat - params_.min_lat) / params_.cell_lat);
+    return static_cast<uint32_t>(clamp(row, 0., double(params_.rows - 1)));
+}
+
+uint32_t GridIndex::Col(double lng) const {
+    const double col = floor((lng - params_.min_lng) / params_.cell_lng);
+    return static_cast<uint32_t>(clamp(col, 0., double(params_.cols - 1)));
+}
+
+double GridIndex::LowerBound(geo::Coordinates coord, uint32_t row, uint32_t col, uint32_t radius) const {
+    const double inf = numeric_limits<double>::infinity();
+    // Точки за пределами квадрата лежат либо выше/ниже его по широте, либо левее/правее по долготе
+    double lat_gap = inf;
+    if (row >= radius + 1) {
+        lat_gap = min(lat_gap, coord.lat - (params_.min_lat + (row - radius) * params_.cell_lat));
+    }
+    if (row + radius + 1 < params_.rows) {
+        lat_gap = min(lat_gap, params_.min_lat + (row + radius + 1) * params_.cell_lat - coord.lat);
+    }
+    double lng_gap = inf;
+    if (col >= radius + 1) {
+        lng_gap = min(lng_gap, coord.lng - (params_.min_lng + (col - radius) * params_.cell_lng));
+    }
+    if (col + radius + 1 < params_.cols) {
+        lng_gap = min(lng_gap, params_.min_lng + (col + radius + 1) * params_.cell_lng - coord.lng);
+    }
+
+    // По формуле гаверсинусов: расстояние не меньше R * dlat и не меньше
+    // 2R * asin(cos(lat1) * cos(lat2) * sin(dlng / 2))
+    const double by_lat = max(lat_gap, 0.) * DR * geo::EARTH_RADIUS;
+    double by_lng = inf;
+    if (lng_gap != inf) {
+        const double c = cos(coord.lat * DR) * min_cos_lat_;
+        by_lng = 2 * geo::EARTH_RADIUS * asin(min(1., c * sin(min(max(lng_gap, 0.) * DR / 2, M_PI / 2))));
+    }
+    return min(by_lat, by_lng);
+}
+
+vector<pair<double, uint32_t>> GridIndex::FindNearest(geo::Coordinates coord, size_t count) const {
+    vector<pair<double, uint32_t>> result;
+    if (Empty() || count == 0) {
+        return result;
+    }
+
+    // Максимальная куча из лучших найденных кандидатов
+    priority_queue<pair<double, uint32_t>> best;
+    vector<double> distances;
+    auto visit_cell = [&](uint32_t row, uint32_t col) {
+        const uint32_t cell = row * params_.cols + col;
+        distances.resize(offsets_[cell + 1] - offsets_[cell]);
+        geo::ComputeDistances(coord, points_, offsets_[cell], offsets_[cell + 1], distances.data());
+        for (uint32_t i = offsets_[cell]; i < offsets_[cell + 1]; ++i) {
+            const pair<double, uint32_t> candidate{distances[i - offsets_[cell]], ids_[i]};
+            if (best.size() < count) {
+                best.push(candidate);
+            } else if (candidate < best.top()) {
+                best.pop();
+                best.push(candidate);
+            }
+        }
+    };
+
+    const uint32_t row = Row(coord.lat);
+    const uint32_t col = Col(coord.lng);
+    for (uint32_t radius = 0;; ++radius) {
+        // Обходим ячейки на границе квадрата радиуса radius вокруг ячейки запроса
+        const int64_t top = int64_t(row) - radius, bottom = int64_t(row) + radius;
+        const int64_t left = int64_t(col) - radius, right = int64_t(col) + radius;
+        for (int64_t r = max<int64_t>(top, 0); r <= min<int64_t>(bottom, params_.rows - 1); ++r) {
+            if (r == top || r == bottom) {
+                for (int64_t c = max<int64_t>(left, 0); c <= min<int64_t>(right, params_.cols - 1); ++c) {
+                    visit_cell(r, c);
+                }
+                continue;
+            }
+            if (left >= 0) {
+                visit_cell(r, left);
+            }
+            if (right < params_.cols) {
+                visit_cell(r, right);
+            }
+        }
+
+        const bool covers_grid = top <= 0 && left <= 0 && bottom >= params_.rows - 1 && right >= params_.cols - 1;
+        if (covers_grid) {
+            break;
+        }
+        // Запас 1e-9 покрывает погрешность приближённого вычисления расстояний
+        if (best.size() == count && LowerBound(coord, row, col, radius) * (1 - 1e-9) > best.top().first) {
+            break;
+        }
+    }
+
+    result.resize(best.size());
+    for (auto it = result.rbegin(); it != result.rend(); ++it) {
+        *it = best.top();
+        best.pop();
+    }
+    return result;
+}
+
+vector<uint32_t> GridIndex::FindInArea(geo::Coordinates min, geo::Coordinates max) const {
+    vector<uint32_t> result;
+    if (Empty() || min.lat > max.lat || min.lng > max.lng) {
+        return result;
+    }
+    // Точки хранятся в радианах, умножение на DR сохраняет порядок и равенство
+    const double min_lat = min.lat * DR, max_lat = max.lat * DR;
+    const double min_lng = min.lng * DR, max_lng = max.lng * DR;
+
+    const uint32_t row_from = Row(min.lat), row_to = Row(max.lat);
+    const uint32_t col_from = Col(min.lng), col_to = Col(max.lng);
+    for (uint32_t r = row_from; r <= row_to; ++r) {
+        const uint32_t begin = offsets_[r * params_.cols + col_from];
+        const uint32_t end = offsets_[r * params_.cols + col_to + 1];
+        // Ячейки одной строки сетки идут в массиве подряд
+        for (uint32_t i = begin; i < end; ++i) {
+            const double lat = points_.lat[i], lng = points_.lng[i];
+            if (lat >= min_lat && lat <= max_lat && lng >= min_lng && lng <= max_lng) {
+                result.push_back(ids_[i]);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace spatial
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "geo.h"
+
+namespace spatial {
+
+// Параметры равномерной сетки: ячейка (row, col) покрывает широты
+// [min_lat + row * cell_lat, min_lat + (row + 1) * cell_lat) и аналогично по долготе
+struct GridParams {
+    double min_lat = 0;
+    double min_lng = 0;
+    double cell_lat = 1;
+    double cell_lng = 1;
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+};
+
+// Пространственный индекс точек на равномерной сетке по широте и долготе.
+// Точки хранятся сгруппированными по ячейкам в формате CSR: точки ячейки c
+// занимают полуинтервал [offsets[c], offsets[c+1]) массивов ids и points.
+class GridIndex {
+public:
+    GridIndex() = default;
+
+    // Строит индекс, идентификатор точки - её позиция в points
+    explicit GridIndex(const std::vector<geo::Coordinates>& points);
+
+    // Восстанавливает сохранённый индекс, points - координаты всех точек по идентификаторам
+    GridIndex(GridParams params, std::vector<uint32_t> offsets, std::vector<uint32_t> ids,
+              const std::vector<geo::Coordinates>& points);
+
+    // Не более count ближайших к coord точек в порядке возрастания расстояния (в метрах)
+    std::vector<std::pair<double, uint32_t>> FindNearest(geo::Coordinates coord, size_t count) const;
+
+    // Точки, попадающие в прямоугольник [min.lat, max.lat] x [min.lng, max.lng]
+    std::vector<uint32_t> FindInArea(geo::Coordinates min, geo::Coordinates max) const;
+
+    bool Empty() const {
+        return ids_.empty();
+    }
+
+    const GridParams& GetParams() const {
+        return params_;
+    }
+
+    const std::vector<uint32_t>& GetOffsets() const {
+        return offsets_;
+    }
+
+    const std::vector<uint32_t>& GetIds() const {
+        return ids_;
+    }
+
+    size_t GetMemoryUsage() const {
+        return (offsets_.capacity() + ids_.capacity()) * sizeof(uint32_t)
+            + (points_.lat.capacity() + points_.lng.capacity() + points_.cos_lat.capacity()) * sizeof(double);
+    }
+
+private:
+    uint32_t Row(double lat) const;
+    uint32_t Col(double lng) const;
+
+    // Нижняя оценка расстояния от coord до любой точки вне квадрата ячеек радиуса radius
+    double LowerBound(geo::Coordinates coord, uint32_t row, uint32_t col, uint32_t radius) const;
+
+    GridParams params_;
+    std::vector<uint32_t> offsets_;
+    std::vector<uint32_t> ids_;
+    geo::PointsArray points_;
+    // Минимальный косинус широты в пределах сетки
+    double min_cos_lat_ = 1;
+};
+
+} // namespace spatial
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace vehicles {
+
+// Ограниченная кольцевая очередь без блокировок для одного писателя и нескольких читателей.
+// Каждая ячейка хранит номер последовательности: ячейка свободна для записи с номером pos,
+// если её номер равен pos, и готова к чтению, если он равен pos + 1.
+template <typename T>
+class SpmcRing {
+    static_assert(std::is_trivially_copyable_v<T>, "SpmcRing stores trivially copyable values");
+
+public:
+    // capacity округляется вверх до степени двойки
+    explicit SpmcRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t Capacity() const {
+        return mask_ + 1;
+    }
+
+    // Вызывается только писателем; возвращает false, если очередь заполнена
+    bool TryPush(const T& value) {
+        const uint64_t pos = tail_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        if (cell.seq.load(std::memory_order_acquire) != pos) {
+            return false;
+        }
+        cell.value = value;
+        cell.seq.store(pos + 1, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Может вызываться несколькими читателями одновременно; возвращает false, если очередь пуста
+    bool TryPop(T& value) {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            const uint64_t seq = cell.seq.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = cell.value;
+                    cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> seq{0};
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+} // namespace vehicles
@@ -1,27 +1,34 @@
 #include "transport_catalogue.h"
 
 #include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "parallel.h"
 
 namespace TrC {
     
 using namespace std;
 
-void TransportCatalogue::AddStop(const Stop& stop) {
-    if (!stops_names_.count(stop.name)) {
-        stops_.push_back(stop);
-        stops_names_[stops_.back().name] = &stops_.back();
+namespace {
 
-        buses_for_stops_[&stops_.back()];
-    }
+// Меньше маршрутов на поток не делится: запуск потока дороже вычисления их длин
+const size_t MIN_BUSES_CHUNK = 256;
+
+} // namespace
+
+Stop& TransportCatalogue::AddStop(const Stop& stop) {
+    return AddStop(Stop(stop));
 }
     
-void TransportCatalogue::AddStop(Stop&& stop) {
-    if (!stops_names_.count(stop.name)) {
-        stops_.push_back(move(stop));
-        stops_names_[stops_.back().name] = &stops_.back();
-
-        buses_for_stops_[&stops_.back()];
+Stop& TransportCatalogue::AddStop(Stop&& stop) {
+    if (const auto it = stops_names_.find(stop.name); it != stops_names_.end()) {
+        return *it->second;
     }
+    stops_.push_back(move(stop));
+    stops_names_[stops_.back().name] = &stops_.back();
+    return stops_.back();
 }
 
 void TransportCatalogue::AddDistances(Stop* from, Stop* to, unsigned distance) {
@@ -32,37 +39,68 @@ void TransportCatalogue::AddDistances(Stop* from, Stop* to, unsigned distance) {
 
 void TransportCatalogue::AddDistances(const std::pair<Stop*,std::vector<detail::DistanceToStop>>& distances) {
     for (const auto& dist : distances.second) {
-        AddDistances(distances.first, stops_names_[dist.stop_name], dist.distance);
+        // Расстояние до неизвестной остановки пропускается: operator[] добавил бы в индекс
+        // остановку без данных, и позиции в нём перестали бы совпадать с номерами остановок
+        if (const auto it = stops_names_.find(dist.stop_name); it != stops_names_.end()) {
+            AddDistances(distances.first, it->second, dist.distance);
+        }
     }
 }
     
 void TransportCatalogue::AddDistances(std::pair<Stop*,std::vector<detail::DistanceToStop>>&& distances) {
-    for (const auto& dist : distances.second) {
-        pair<Stop*, Stop*> pr(move(distances.first), stops_names_[dist.stop_name]);
-        if (!distances_.count(pr)) {
-            distances_[move(pr)] = move(dist.distance);
-        }
-    }
+    AddDistances(distances);
 }
 
 void TransportCatalogue::AddBus(const Bus& bus) {
     if (!buses_names_.count(bus.name)) {
         buses_.push_back(bus);
+        ResolveLengths(buses_.back());
         buses_names_[buses_.back().name] = &buses_.back();
-
-        for (const auto& elem : buses_.back().route) {
-            buses_for_stops_[elem].insert(buses_.back().name);
-        }
     }
 }
     
 void TransportCatalogue::AddBus(Bus&& bus) {
     if (!buses_names_.count(bus.name)) {
         buses_.push_back(move(bus));
+        ResolveLengths(buses_.back());
         buses_names_[buses_.back().name] = &buses_.back();
+    }
+}
 
-        for (const auto& elem : buses_.back().route) {
-            buses_for_stops_[elem].insert(buses_.back().name);
+void TransportCatalogue::AddBuses(vector<Bus>&& buses) {
+    const size_t first = buses_.size();
+    for (Bus& bus : buses) {
+        if (!buses_names_.count(bus.name)) {
+            buses_.push_back(move(bus));
+            buses_names_[buses_.back().name] = &buses_.back();
+        }
+    }
+    // Вычисление длин только читает остановки и расстояния и пишет в свой маршрут
+    parallel::ForEachChunk(buses_.size() - first, [this, first](size_t begin, size_t end) {
+        for (size_t i = first + begin; i < first + end; ++i) {
+            ResolveLengths(buses_[i]);
+        }
+    }, MIN_BUSES_CHUNK);
+}
+
+void TransportCatalogue::ResolveLengths(Bus& bus) const {
+    bus.forward_lengths.assign(bus.route.size(), 0);
+    for (size_t i = 0; i + 1 < bus.route.size(); ++i) {
+        bus.forward_lengths[i+1] = bus.forward_lengths[i] + StopsDistance({bus.route[i], bus.route[i+1]});
+    }
+    
+    geo::PointsArray points;
+    points.Reserve(bus.route.size());
+    for (const Stop* stop : bus.route) {
+        points.Add(stop->coord);
+    }
+    bus.geo_length = geo::ComputeLength(points);
+    
+    bus.backward_lengths.clear();
+    if (!bus.is_ring) {
+        bus.backward_lengths.assign(bus.route.size(), 0);
+        for (size_t i = 0; i + 1 < bus.route.size(); ++i) {
+            bus.backward_lengths[i+1] = bus.backward_lengths[i] + StopsDistance({bus.route[i+1], bus.route[i]});
         }
     }
 }
@@ -79,43 +117,187 @@ BusInfo TransportCatalogue::GetBusInfo(string_view name) const {
     BusInfo info;
     Bus* bus = buses_names_.at(name);
     int num = bus->route.size();
-    unordered_set<Stop*> unique_stop;
-    for (size_t i = 0; i + 1 < bus->route.size(); ++i) {
-        info.length += ComputeDistance(bus->route[i]->coord, bus->route[i+1]->coord);
-        auto it = distances_.find({bus->route[i], bus->route[i+1]});
-        if (it == distances_.end()) {
-            it = distances_.find({bus->route[i+1], bus->route[i]});
-        }
-        info.real_length += (*it).second;
-
-        unique_stop.insert(bus->route[i]);
-    }
-    unique_stop.insert(bus->route.back());
+    vector<Stop*> unique_stop(bus->route);
+    sort(unique_stop.begin(), unique_stop.end());
+    info.length = bus->geo_length;
+    info.real_length = bus->forward_lengths.back();
 
     if (!bus->is_ring) {
         info.length *= 2;
         num *= 2;
         num -= 1;
-        for (size_t i = 0; i + 1 < bus->route.size(); ++i) {
-            auto it = distances_.find({bus->route[i+1], bus->route[i]});
-            if (it == distances_.end()) {
-                it = distances_.find({bus->route[i], bus->route[i+1]});
-            }
-            info.real_length += (*it).second;
-        }
+        info.real_length += bus->backward_lengths.back();
     }
 
     info.stops = num;
-    info.unique_stops = unique_stop.size();
+    info.unique_stops = unique(unique_stop.begin(), unique_stop.end()) - unique_stop.begin();
 
     return info;
 }
 
-vector<string_view> TransportCatalogue::GetBusesForStop(std::string_view name) const {
-    Stop* stop = stops_names_.at(name);
-    vector<string_view> buses(buses_for_stops_.at(stop).begin(), buses_for_stops_.at(stop).end());
-    sort(buses.begin(), buses.end());
-    return buses;
+void TransportCatalogue::BuildBusesForStopsIndex() {
+    vector<pair<uint32_t, string_view>> stop_bus;
+    for (const auto& bus : buses_) {
+        for (const Stop* stop : bus.route) {
+            stop_bus.emplace_back(stops_names_.find(stop->name) - stops_names_.begin(), bus.name);
+        }
+    }
+    sort(stop_bus.begin(), stop_bus.end());
+    stop_bus.erase(unique(stop_bus.begin(), stop_bus.end()), stop_bus.end());
+    
+    stop_buses_offsets_.assign(stops_.size() + 1, 0);
+    stop_buses_.clear();
+    stop_buses_.reserve(stop_bus.size());
+    for (const auto& [stop_id, bus_name] : stop_bus) {
+        ++stop_buses_offsets_[stop_id + 1];
+        stop_buses_.push_back(bus_name);
+    }
+    partial_sum(stop_buses_offsets_.begin(), stop_buses_offsets_.end(), stop_buses_offsets_.begin());
+}
+
+void TransportCatalogue::SetBusesForStopsIndex(vector<uint32_t> offsets, const vector<uint32_t>& bus_ids) {
+    // Смещения из файла базы должны задавать полуинтервалы внутри bus_ids, иначе
+    // GetBusesForStop прочитал бы за границами массива
+    if (offsets.size() != stops_.size() + 1 || offsets.front() != 0 || offsets.back() != bus_ids.size()
+        || !is_sorted(offsets.begin(), offsets.end())) {
+        throw invalid_argument("Buses for stops index does not match catalogue");
+    }
+    stop_buses_offsets_ = move(offsets);
+    stop_buses_.clear();
+    stop_buses_.reserve(bus_ids.size());
+    for (const uint32_t id : bus_ids) {
+        stop_buses_.push_back(buses_.at(id).name);
+    }
+}
+
+void TransportCatalogue::BuildSpatialIndex() {
+    vector<geo::Coordinates> points;
+    points.reserve(stops_.size());
+    for (const auto& stop : stops_) {
+        points.push_back(stop.coord);
+    }
+    stops_grid_ = spatial::GridIndex(points);
+}
+
+void TransportCatalogue::SetSpatialIndex(spatial::GridParams params, vector<uint32_t> offsets, 
+                                         vector<uint32_t> ids) {
+    vector<geo::Coordinates> points;
+    points.reserve(stops_.size());
+    for (const auto& stop : stops_) {
+        points.push_back(stop.coord);
+    }
+    stops_grid_ = spatial::GridIndex(params, move(offsets), move(ids), points);
+}
+
+vector<pair<const Stop*, double>> TransportCatalogue::FindNearestStops(geo::Coordinates coord, 
+                                                                      size_t count) const {
+    vector<pair<const Stop*, double>> result;
+    for (const auto& [distance, id] : stops_grid_.FindNearest(coord, count)) {
+        result.emplace_back(&stops_[id], distance);
+    }
+    return result;
+}
+
+vector<const Stop*> TransportCatalogue::FindStopsInArea(geo::Coordinates min, geo::Coordinates max) const {
+    vector<const Stop*> result;
+    for (const uint32_t id : stops_grid_.FindInArea(min, max)) {
+        result.push_back(&stops_[id]);
+    }
+    sort(result.begin(), result.end(), [](const Stop* lhs, const Stop* rhs) {
+        return lhs->name < rhs->name;
+    });
+    return result;
+}
+
+void TransportCatalogue::BuildNameIndex() {
+    vector<pair<string_view, uint32_t>> names;
+    names.reserve(stops_.size() + buses_.size());
+    for (uint32_t id = 0; id < stops_.size(); ++id) {
+        names.emplace_back(stops_[id].name, id << 1);
+    }
+    for (uint32_t id = 0; id < buses_.size(); ++id) {
+        names.emplace_back(buses_[id].name, (id << 1) | 1);
+    }
+    names_index_ = search::NameIndex(move(names));
+}
+
+void TransportCatalogue::SetNameIndex(search::NameIndex index) {
+    for (const uint32_t value : index.GetValues()) {
+        if ((value & 1 ? buses_.size() : stops_.size()) <= (value >> 1)) {
+            throw invalid_argument("Name index refers to unknown stop or bus");
+        }
+    }
+    names_index_ = move(index);
+}
+
+NameMatch TransportCatalogue::MakeNameMatch(uint32_t value) const {
+    if (value & 1) {
+        return {buses_[value >> 1].name, true};
+    }
+    return {stops_[value >> 1].name, false};
+}
+
+vector<NameMatch> TransportCatalogue::FindNamesByPrefix(string_view prefix, size_t limit) const {
+    vector<NameMatch> result;
+    for (const uint32_t value : names_index_.FindByPrefix(prefix, limit)) {
+        result.push_back(MakeNameMatch(value));
+    }
+    return result;
+}
+
+vector<NameMatch> TransportCatalogue::FindSimilarNames(string_view name, size_t limit) const {
+    vector<NameMatch> result;
+    // Индекс упорядочивает похожие имена по значению, поэтому сортируем все и только потом обрезаем.
+    // Устойчивая сортировка сохраняет порядок одноимённых остановки и маршрута таким же, как в FindNamesByPrefix
+    for (const uint32_t value : names_index_.FindSimilar(name, numeric_limits<size_t>::max())) {
+        result.push_back(MakeNameMatch(value));
+    }
+    stable_sort(result.begin(), result.end(), [](const NameMatch& lhs, const NameMatch& rhs) {
+        return lhs.name < rhs.name;
+    });
+    if (result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
+
+memory::Report TransportCatalogue::GetMemoryUsage() const {
+    memory::Report report;
+    
+    memory::Usage stops{"catalogue.stops"s, memory::DequeBytes(stops_), stops_.size()};
+    for (const auto& stop : stops_) {
+        stops.bytes += memory::StringBytes(stop.name);
+    }
+    report.push_back(move(stops));
+    
+    memory::Usage buses{"catalogue.buses"s, memory::DequeBytes(buses_), buses_.size()};
+    for (const auto& bus : buses_) {
+        buses.bytes += memory::StringBytes(bus.name) + memory::VectorBytes(bus.route) 
+            + memory::VectorBytes(bus.forward_lengths) + memory::VectorBytes(bus.backward_lengths);
+    }
+    report.push_back(move(buses));
+    
+    report.push_back({"catalogue.stops_index"s, stops_names_.GetMemoryUsage(), stops_names_.size()});
+    report.push_back({"catalogue.buses_index"s, buses_names_.GetMemoryUsage(), buses_names_.size()});
+    report.push_back({"catalogue.distances"s, distances_.GetMemoryUsage(), distances_.size()});
+    report.push_back({"catalogue.buses_for_stops"s, 
+                      memory::VectorBytes(stop_buses_offsets_) + memory::VectorBytes(stop_buses_), stop_buses_.size()});
+    report.push_back({"catalogue.spatial_index"s, stops_grid_.GetMemoryUsage(), stops_grid_.GetIds().size()});
+    report.push_back({"catalogue.name_index"s, names_index_.GetMemoryUsage(), names_index_.NodeCount()});
+    
+    return report;
+}
+
+BusesRange TransportCatalogue::GetBusesForStop(std::string_view name) const {
+    const size_t stop_id = stops_names_.find(name) - stops_names_.begin();
+    if (stop_id >= stops_names_.size()) {
+        throw out_of_range("Stop not found");
+    }
+    if (stop_buses_offsets_.size() != stops_.size() + 1) {
+        throw logic_error("Buses for stops index is not built");
+    }
+    return {stop_buses_.begin() + stop_buses_offsets_[stop_id], 
+            stop_buses_.begin() + stop_buses_offsets_[stop_id + 1]};
 }
     
 } // namespace TrC
\ No newline at end of file
@@ -1,36 +1,106 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <deque>
 #include <string_view>
-#include <unordered_map>
-#include <unordered_set>
-#include <unordered_map>
 
 #include "domain.h"
+#include "flat_hash_map.h"
+#include "memory_usage.h"
+#include "name_index.h"
+#include "ranges.h"
+#include "spatial_index.h"
 #include "svg.h"
 #include "map_renderer.h"
 
 namespace TrC {
 
+using StopsIndex = flat::HashMap<std::string_view, Stop*>;
+using BusesIndex = flat::HashMap<std::string_view, Bus*>;
+using DistancesIndex = flat::HashMap<std::pair<Stop*, Stop*>, unsigned, detail::PairHash>;
+using BusesRange = ranges::Range<std::vector<std::string_view>::const_iterator>;
+
+// Имя, найденное поиском по индексу имён
+struct NameMatch {
+    std::string_view name;
+    bool is_bus = false;
+};
+
 class TransportCatalogue {
 public:
     TransportCatalogue() = default;
+    // Остановки и маршруты ссылаются друг на друга по указателям, поэтому копирование запрещено
+    TransportCatalogue(const TransportCatalogue&) = delete;
+    TransportCatalogue& operator=(const TransportCatalogue&) = delete;
 
-    void AddStop(const Stop& stop);
-    void AddStop(Stop&& stop);
+    // Возвращают добавленную остановку или уже имеющуюся остановку с тем же именем
+    Stop& AddStop(const Stop& stop);
+    Stop& AddStop(Stop&& stop);
         
+    // Расстояния между остановками маршрута должны быть добавлены до самого маршрута
     void AddBus(const Bus& bus);
     void AddBus(Bus&& bus);
+    // Добавляет маршруты в том же порядке, что и AddBus; длины маршрутов вычисляются параллельно
+    void AddBuses(std::vector<Bus>&& buses);
         
     void AddDistances(Stop* from, Stop* to, unsigned distance);
+    // Расстояния до остановок, которых нет в справочнике, пропускаются
     void AddDistances(const std::pair<Stop*,std::vector<detail::DistanceToStop>>& distances);
     void AddDistances(std::pair<Stop*,std::vector<detail::DistanceToStop>>&& distances);
         
     Bus& FindBus(std::string_view name) const;
     Stop& FindStop(std::string_view name) const;
     BusInfo GetBusInfo(std::string_view name) const;
-    std::vector<std::string_view> GetBusesForStop(std::string_view name) const;
+    // Отсортированные по имени маршруты, проходящие через остановку.
+    // Требует построенного индекса (BuildBusesForStopsIndex или SetBusesForStopsIndex)
+    BusesRange GetBusesForStop(std::string_view name) const;
+    
+    // Строит индекс маршрутов по остановкам в формате CSR: маршруты остановки с номером i
+    // занимают полуинтервал [offsets[i], offsets[i+1]) общего массива. Вызывается после
+    // добавления всех маршрутов, последующие AddStop/AddBus требуют повторного построения
+    void BuildBusesForStopsIndex();
+    // Устанавливает индекс, сохранённый в базе; бросает std::invalid_argument, если он не
+    // согласован со справочником
+    void SetBusesForStopsIndex(std::vector<uint32_t> offsets, const std::vector<uint32_t>& bus_ids);
+    
+    const std::vector<uint32_t>& GetBusesForStopsOffsets() const {
+        return stop_buses_offsets_;
+    }
+    
+    const std::vector<std::string_view>& GetBusesForStops() const {
+        return stop_buses_;
+    }
+    
+    // Пространственный индекс остановок строится после добавления всех остановок
+    void BuildSpatialIndex();
+    void SetSpatialIndex(spatial::GridParams params, std::vector<uint32_t> offsets, std::vector<uint32_t> ids);
+    
+    const spatial::GridIndex& GetSpatialIndex() const {
+        return stops_grid_;
+    }
+    
+    // Не более count ближайших к coord остановок с расстояниями до них в метрах
+    std::vector<std::pair<const Stop*, double>> FindNearestStops(geo::Coordinates coord, size_t count) const;
+    // Остановки внутри прямоугольника координат, отсортированные по имени
+    std::vector<const Stop*> FindStopsInArea(geo::Coordinates min, geo::Coordinates max) const;
+    
+    // Индекс имён остановок и маршрутов для поиска по префиксу и с опечаткой. Значение имени
+    // в индексе - номер остановки или маршрута, сдвинутый на бит, младший бит отличает маршрут
+    void BuildNameIndex();
+    void SetNameIndex(search::NameIndex index);
+    
+    const search::NameIndex& GetNameIndex() const {
+        return names_index_;
+    }
+    
+    // Не более limit имён, начинающихся с prefix, в лексикографическом порядке
+    std::vector<NameMatch> FindNamesByPrefix(std::string_view prefix, size_t limit) const;
+    // Не более limit имён, отличающихся от name не более чем на один символ, в лексикографическом порядке
+    std::vector<NameMatch> FindSimilarNames(std::string_view name, size_t limit) const;
+    
+    // Оценка памяти остановок, маршрутов и индексов справочника
+    memory::Report GetMemoryUsage() const;
     
     unsigned StopsDistance(std::pair<Stop*, Stop*> stops) const {
         auto it = distances_.find(stops);
@@ -48,16 +118,15 @@ public:
         return buses_names_.count(name);
     }
     
-    const std::unordered_map<std::string_view, Bus*>& GetBuses() const {
+    const BusesIndex& GetBuses() const {
         return buses_names_;
     }
     
-    const std::unordered_map<std::string_view, Stop*>& GetStops() const {
+    const StopsIndex& GetStops() const {
         return stops_names_;
     }
     
-    const std::unordered_map<std::pair<Stop*, Stop*>, unsigned, detail::PairHash>& 
-        GetDistances() const {
+    const DistancesIndex& GetDistances() const {
         return distances_;
     }
     
@@ -78,12 +147,18 @@ public:
     }
     
 private:
+    void ResolveLengths(Bus& bus) const;
+    NameMatch MakeNameMatch(uint32_t value) const;
+    
     std::deque<Stop> stops_;
-    std::unordered_map<std::string_view, Stop*> stops_names_;
+    StopsIndex stops_names_;
     std::deque<Bus> buses_;
-    std::unordered_map<std::string_view, Bus*> buses_names_;
-    std::unordered_map<Stop*, std::unordered_set<std::string_view>> buses_for_stops_;
-    std::unordered_map<std::pair<Stop*, Stop*>, unsigned, detail::PairHash> distances_;
+    BusesIndex buses_names_;
+    std::vector<uint32_t> stop_buses_offsets_;
+    std::vector<std::string_view> stop_buses_;
+    spatial::GridIndex stops_grid_;
+    search::NameIndex names_index_;
+    DistancesIndex distances_;
 };
     
 } // namespace TrC
\ No newline at end of file
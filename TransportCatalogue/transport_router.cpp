@@ -29,9 +29,8 @@ graph::Edge<RouteWeight> MakeEdge(TrC::Bus* bus, const TrC::TransportCatalogue&
     return edge;
 }
 
-double Distance(TrC::Bus* bus, const TrC::TransportCatalogue& catalogue,
-                        size_t stop_from, size_t stop_to) {
-    return catalogue.StopsDistance({bus->route.at(stop_from), bus->route.at(stop_to)});
+double Distance(const TrC::Bus* bus, size_t stop_from, size_t stop_to) {
+    return bus->SpanDistance(stop_from, stop_to);
 }
 
     
@@ -39,21 +38,17 @@ Graph GraphInit(RoutingSettings settings, const TrC::TransportCatalogue& catalog
     Graph graph(catalogue.GetStops().size());  
     
     for (const auto& [bus_name, bus] : catalogue.GetBuses()) {
-        for(size_t i = 0; i < bus->route.size() - 1; ++i) {
-            double route_time = settings.wait_time;
-            double return_route_time = route_time;
-            for(size_t j = i + 1; j < bus->route.size(); ++j) {
+        const size_t last = bus->route.size() - 1;
+        for(size_t i = 0; i < last; ++i) {
+            for(size_t j = i + 1; j <= last; ++j) {
                 graph::Edge<RouteWeight> edge = MakeEdge(bus, catalogue, i, j);
-                route_time += Distance(bus, catalogue, j - 1, j) / (settings.velocity * factor);
-                edge.weight.route_time = route_time;
+                edge.weight.route_time = settings.wait_time + Distance(bus, i, j) / (settings.velocity * factor);
                 graph.AddEdge(edge);
             
                 if (!bus->is_ring) {
-                    graph::Edge<RouteWeight> edge = MakeEdge(bus, catalogue, bus->route.size() - 1 - i, 
-                                                                            bus->route.size() - 1 - j);
-                    return_route_time += Distance(bus, catalogue, bus->route.size() - j, 
-                                             bus->route.size() - 1 - j) / (settings.velocity * factor);
-                    edge.weight.route_time = return_route_time;
+                    graph::Edge<RouteWeight> edge = MakeEdge(bus, catalogue, last - i, last - j);
+                    edge.weight.route_time = settings.wait_time + 
+                                             Distance(bus, last - i, last - j) / (settings.velocity * factor);
                     graph.AddEdge(edge);
                 }
             }
@@ -62,7 +57,7 @@ Graph GraphInit(RoutingSettings settings, const TrC::TransportCatalogue& catalog
     return graph;
 }
 
-optional<vector<RouterEdge>> TransportRouter::BuildRoute(const string& from, const string& to) {
+optional<vector<RouterEdge>> TransportRouter::BuildRoute(const string& from, const string& to) const {
     vector<RouterEdge> result;
     if (from == to) {
         return result;
@@ -91,4 +86,21 @@ RoutingSettings TransportRouter::GetSettings() const {
     return settings_;
 }
 
+memory::Report TransportRouter::GetMemoryUsage() const {
+    memory::Usage graph{"router.graph"s, memory::VectorBytes(graph_.GetEdges()) 
+                        + memory::VectorBytes(graph_.GetIncidenceLists()), graph_.GetEdgeCount()};
+    for (const auto& incidence_list : graph_.GetIncidenceLists()) {
+        graph.bytes += memory::VectorBytes(incidence_list);
+    }
+    
+    const auto& routes = router_.GetRoutesInternalData();
+    memory::Usage table{"router.routes"s, memory::VectorBytes(routes), 0};
+    for (const auto& row : routes) {
+        table.bytes += memory::VectorBytes(row);
+        table.count += row.size();
+    }
+    
+    return {graph, table};
+}
+
 } // namespace router
\ No newline at end of file
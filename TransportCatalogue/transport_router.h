@@ -1,5 +1,6 @@
 #pragma once
 
+#include "memory_usage.h"
 #include "transport_catalogue.h"
 #include "graph.h"
 #include "router.h"
@@ -38,8 +39,7 @@ RouteWeight operator+(const RouteWeight&, const RouteWeight&);
 graph::Edge<RouteWeight> MakeEdge(TrC::Bus* bus, const TrC::TransportCatalogue& catalogue,
                                 size_t stop_from, size_t stop_to);
     
-double Distance(TrC::Bus* bus, const TrC::TransportCatalogue& catalogue,
-                                size_t stop_from, size_t stop_to);
+double Distance(const TrC::Bus* bus, size_t stop_from, size_t stop_to);
     
 Graph GraphInit(RoutingSettings settings, const TrC::TransportCatalogue& catalogue);
 
@@ -65,10 +65,14 @@ public:
     catalogue_{catalogue}, settings_{settings}, graph_{graph}, router_{router} {
     }
 
-    std::optional<std::vector<RouterEdge>> BuildRoute(const std::string& from, const std::string& to);
+    // Только читает граф и таблицу маршрутов, поэтому может вызываться из нескольких потоков
+    std::optional<std::vector<RouterEdge>> BuildRoute(const std::string& from, const std::string& to) const;
 
     RoutingSettings GetSettings() const;
     
+    // Оценка памяти графа и таблицы кратчайших маршрутов
+    memory::Report GetMemoryUsage() const;
+    
     const Graph& GetGraph() const {
         return graph_;
     }
@@ -0,0 +1,270 @@
+#include "vehicle_positions.h"
+
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace vehicles {
+
+using namespace std;
+
+namespace {
+
+// Интервал, с которым блокирующиеся потоки проверяют запрос на остановку
+const int POLL_TIMEOUT_MS = 50;
+// Столько попыток захватить запись ждут на процессоре, следующие уступают его другим потокам
+const unsigned SPIN_ATTEMPTS = 64;
+
+// Ожидание перед следующей попыткой, пока запись занята писателем. Писатель мог быть вытеснен,
+// поэтому после короткого ожидания поток уступает ему процессор
+void Backoff(unsigned& attempt) {
+    if (attempt++ < SPIN_ATTEMPTS) {
+#if defined(__SSE2__)
+        _mm_pause();
+#endif
+    } else {
+        this_thread::yield();
+    }
+}
+
+string_view NextToken(string_view& line) {
+    const size_t begin = line.find_first_not_of(" \t");
+    if (begin == string_view::npos) {
+        line = {};
+        return {};
+    }
+    line.remove_prefix(begin);
+    const size_t end = min(line.find_first_of(" \t"), line.size());
+    const string_view token = line.substr(0, end);
+    line.remove_prefix(end);
+    return token;
+}
+
+template <typename Number>
+bool ParseNumber(string_view token, Number& value) {
+    const auto [ptr, ec] = from_chars(token.data(), token.data() + token.size(), value);
+    return !token.empty() && ec == errc() && ptr == token.data() + token.size();
+}
+
+} // namespace
+
+PositionTable::PositionTable(size_t bus_count) : entries_(make_unique<Entry[]>(bus_count)), size_(bus_count) {
+}
+
+void PositionTable::Update(uint32_t bus_id, Position position) {
+    Entry& entry = entries_[bus_id];
+    uint64_t seq = entry.seq.load(memory_order_relaxed);
+    // Захватываем запись, переводя счётчик в нечётное состояние
+    for (unsigned attempt = 0; (seq & 1) || !entry.seq.compare_exchange_weak(seq, seq + 1, memory_order_acquire);) {
+        Backoff(attempt);
+        seq = entry.seq.load(memory_order_relaxed);
+    }
+    if (!entry.known.load(memory_order_relaxed) || entry.timestamp.load(memory_order_relaxed) <= position.timestamp) {
+        entry.lat.store(position.coord.lat, memory_order_relaxed);
+        entry.lng.store(position.coord.lng, memory_order_relaxed);
+        entry.timestamp.store(position.timestamp, memory_order_relaxed);
+        entry.known.store(true, memory_order_relaxed);
+    }
+    entry.seq.store(seq + 2, memory_order_release);
+}
+
+optional<Position> PositionTable::Read(const Entry& entry) const {
+    for (unsigned attempt = 0;; Backoff(attempt)) {
+        const uint64_t before = entry.seq.load(memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        const bool known = entry.known.load(memory_order_relaxed);
+        const Position position{{entry.lat.load(memory_order_relaxed), entry.lng.load(memory_order_relaxed)},
+                                entry.timestamp.load(memory_order_relaxed)};
+        atomic_thread_fence(memory_order_acquire);
+        if (entry.seq.load(memory_order_relaxed) == before) {
+            return known ? optional<Position>(position) : nullopt;
+        }
+    }
+}
+
+optional<Position> PositionTable::Get(uint32_t bus_id) const {
+    if (bus_id >= size_) {
+        return nullopt;
+    }
+    return Read(entries_[bus_id]);
+}
+
+vector<pair<uint32_t, Position>> PositionTable::FindInArea(geo::Coordinates min, geo::Coordinates max) const {
+    vector<pair<uint32_t, Position>> result;
+    for (uint32_t id = 0; id < size_; ++id) {
+        const auto position = Read(entries_[id]);
+        if (position && position->coord.lat >= min.lat && position->coord.lat <= max.lat
+            && position->coord.lng >= min.lng && position->coord.lng <= max.lng) {
+            result.emplace_back(id, *position);
+        }
+    }
+    return result;
+}
+
+PositionFeed::PositionFeed(const TrC::TransportCatalogue& catalogue, PositionTable& table,
+                           size_t workers, size_t capacity)
+    : catalogue_{catalogue}, table_{table}, workers_count_{max<size_t>(workers, 1)}, ring_{capacity} {
+}
+
+PositionFeed::~PositionFeed() {
+    Stop();
+}
+
+void PositionFeed::Start(const string& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    if (fd < 0) {
+        throw runtime_error("Failed to open positions feed "s + path + ": "s + strerror(errno));
+    }
+    producer_ = thread([this, fd] {
+        Produce(fd);
+        close(fd);
+    });
+    for (size_t i = 0; i < workers_count_; ++i) {
+        workers_.emplace_back([this] { Consume(); });
+    }
+}
+
+void PositionFeed::Wait() {
+    if (producer_.joinable()) {
+        producer_.join();
+    }
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void PositionFeed::Stop() {
+    stop_ = true;
+    Wait();
+}
+
+optional<PositionUpdate> PositionFeed::ParseLine(string_view line) const {
+    const string_view timestamp = NextToken(line);
+    const string_view lat = NextToken(line);
+    const string_view lng = NextToken(line);
+    const size_t name_begin = line.find_first_not_of(" \t");
+    if (name_begin == string_view::npos) {
+        return nullopt;
+    }
+    line.remove_prefix(name_begin);
+    while (!line.empty() && (line.back() == ' ' || line.back() == '\t' || line.back() == '\r')) {
+        line.remove_suffix(1);
+    }
+
+    PositionUpdate update;
+    if (!ParseNumber(timestamp, update.position.timestamp) || !ParseNumber(lat, update.position.coord.lat)
+        || !ParseNumber(lng, update.position.coord.lng)) {
+        return nullopt;
+    }
+    const auto it = catalogue_.GetBuses().find(line);
+    if (it == catalogue_.GetBuses().end()) {
+        return nullopt;
+    }
+    update.bus_id = static_cast<uint32_t>(it - catalogue_.GetBuses().begin());
+    return update;
+}
+
+void PositionFeed::Produce(int fd) {
+    string pending;
+    char buffer[1 << 16];
+    auto push = [this](const PositionUpdate& update) {
+        // При заполненной очереди ждёт писателя, не теряя обновлений
+        while (!ring_.TryPush(update)) {
+            if (stop_) {
+                return;
+            }
+            this_thread::yield();
+        }
+    };
+    auto process_lines = [&](bool flush) {
+        size_t begin = 0;
+        for (size_t end; (end = pending.find('\n', begin)) != string::npos; begin = end + 1) {
+            const string_view line(pending.data() + begin, end - begin);
+            if (line.find_first_not_of(" \t\r") == string_view::npos) {
+                continue;
+            }
+            if (const auto update = ParseLine(line)) {
+                push(*update);
+            } else {
+                ++rejected_;
+            }
+        }
+        pending.erase(0, begin);
+        if (flush && !pending.empty()) {
+            if (const auto update = ParseLine(pending)) {
+                push(*update);
+            } else {
+                ++rejected_;
+            }
+            pending.clear();
+        }
+    };
+
+    struct stat info;
+    const bool is_fifo = fstat(fd, &info) == 0 && S_ISFIFO(info.st_mode);
+    bool received = false;
+    while (!stop_) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+        const ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (count == 0) {
+            // Канал без писателя сразу сообщает о конце данных: ждём, пока писатель появится
+            if (is_fifo && !received) {
+                this_thread::sleep_for(chrono::milliseconds(POLL_TIMEOUT_MS));
+                continue;
+            }
+            break;
+        }
+        received = true;
+        pending.append(buffer, count);
+        process_lines(false);
+    }
+    process_lines(true);
+    input_done_ = true;
+}
+
+void PositionFeed::Consume() {
+    PositionUpdate update;
+    while (true) {
+        if (ring_.TryPop(update)) {
+            table_.Update(update.bus_id, update.position);
+            ++accepted_;
+            continue;
+        }
+        if (input_done_ || stop_) {
+            // Писатель завершился: дочитываем то, что осталось в очереди
+            if (!ring_.TryPop(update)) {
+                return;
+            }
+            table_.Update(update.bus_id, update.position);
+            ++accepted_;
+            continue;
+        }
+        this_thread::sleep_for(chrono::microseconds(100));
+    }
+}
+
+} // namespace vehicles
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "geo.h"
+#include "spmc_ring.h"
+#include "transport_catalogue.h"
+
+namespace vehicles {
+
+struct Position {
+    geo::Coordinates coord;
+    // Время в секундах от начала эпохи Unix
+    int64_t timestamp = 0;
+};
+
+// Обновление положения автобуса, id - позиция маршрута в TransportCatalogue::GetBuses()
+struct PositionUpdate {
+    uint32_t bus_id = 0;
+    Position position;
+};
+
+// Последнее известное положение каждого автобуса. Запись и чтение не блокируют друг друга:
+// каждая запись защищена счётчиком версий (seqlock), читатель повторяет чтение при конфликте
+class PositionTable {
+public:
+    explicit PositionTable(size_t bus_count);
+
+    // Сохраняет положение, если оно не старше уже известного
+    void Update(uint32_t bus_id, Position position);
+
+    std::optional<Position> Get(uint32_t bus_id) const;
+
+    // Автобусы, последнее положение которых лежит внутри прямоугольника
+    std::vector<std::pair<uint32_t, Position>> FindInArea(geo::Coordinates min, geo::Coordinates max) const;
+
+    size_t Size() const {
+        return size_;
+    }
+
+private:
+    struct alignas(64) Entry {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<double> lat{0};
+        std::atomic<double> lng{0};
+        std::atomic<int64_t> timestamp{0};
+        std::atomic<bool> known{false};
+    };
+
+    std::optional<Position> Read(const Entry& entry) const;
+
+    std::unique_ptr<Entry[]> entries_;
+    size_t size_;
+};
+
+struct FeedStats {
+    uint64_t accepted = 0;
+    uint64_t rejected = 0;
+};
+
+// Поток обновлений положений из файла или канала. Каждая строка имеет вид
+// "<timestamp> <latitude> <longitude> <bus name>". Строки разбирает один поток-писатель,
+// обновления передаются через очередь SpmcRing потокам, записывающим их в PositionTable
+class PositionFeed {
+public:
+    PositionFeed(const TrC::TransportCatalogue& catalogue, PositionTable& table,
+                 size_t workers = 2, size_t capacity = 1 << 16);
+    PositionFeed(const PositionFeed&) = delete;
+    PositionFeed& operator=(const PositionFeed&) = delete;
+    ~PositionFeed();
+
+    // Начинает чтение файла или именованного канала path; бросает std::runtime_error,
+    // если его не удалось открыть
+    void Start(const std::string& path);
+
+    // Дожидается конца входных данных и обработки всех обновлений
+    void Wait();
+
+    // Прекращает чтение, не дожидаясь конца входных данных
+    void Stop();
+
+    FeedStats GetStats() const {
+        return {accepted_.load(), rejected_.load()};
+    }
+
+    // Разбирает строку обновления; nullopt, если строка некорректна или маршрут неизвестен
+    std::optional<PositionUpdate> ParseLine(std::string_view line) const;
+
+private:
+    void Produce(int fd);
+    void Consume();
+
+    const TrC::TransportCatalogue& catalogue_;
+    PositionTable& table_;
+    size_t workers_count_;
+    SpmcRing<PositionUpdate> ring_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> input_done_{false};
+    std::atomic<uint64_t> accepted_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::thread producer_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace vehicles